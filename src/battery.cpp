@@ -17,12 +17,15 @@ COMPONENT_TEMPLATE(Battery);
 
 REGISTER_LEVEL_ENTITY(Battery);
 
+static const Level::FieldId IDENTIFIER_FIELD = Level::field_id("Identifier");
+static const Level::FieldId COLLECTED_FIELD  = Level::field_id("Collected");
+
 Battery::Battery(const Level::Entity &entity)
 {
   start_x = entity.position.x;
   start_y = entity.position.y;
 
-  Level::read_field(entity.fields, "Identifier", level_entity_id);
+  Level::read_field(entity.fields, IDENTIFIER_FIELD, level_entity_id);
 }
 
 void Battery::init()
@@ -34,10 +37,11 @@ void Battery::init()
   physics.y     = start_y + 8;
   physics.solid = true;
 
-  auto &renderer         = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
-  auto &sprite           = renderer.sprite_interpolated.sprite;
-  sprite.source_offset.x = 56;
-  sprite.source_offset.y = 88;
+  auto &renderer          = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
+  renderer.follow_physics = true;
+  auto &sprite            = renderer.sprite_interpolated.sprite;
+  sprite.source_offset.x  = 56;
+  sprite.source_offset.y  = 88;
   sprite.set_frame_count(1);
   sprite.set_frame_width(16);
   sprite.set_frame_height(16);
@@ -73,7 +77,7 @@ void Battery::init()
   // sound = GameSound();
 
   Level::Field collected_field;
-  Level::Level::load(level_entity_id, "Collected", collected_field);
+  Level::Level::load(level_entity_id, COLLECTED_FIELD, collected_field);
   if (auto collected = std::get_if<bool>(&collected_field); collected && *collected)
   {
     used = true;
@@ -96,7 +100,6 @@ void Battery::postupdate()
 {
   auto &renderer = get_component<SpriteRenderer>(entity).get();
   auto &physics  = get_component<Physics>(entity).get();
-  renderer.set_position(physics.x, physics.y);
 
   if (used)
   {
@@ -131,7 +134,7 @@ void Battery::postupdate()
 
       light.intensity = 10.0f;
       light.size      = 2.0f;
-      Level::Level::store(level_entity_id, "Collected", true);
+      Level::Level::store(level_entity_id, COLLECTED_FIELD, true);
 
       for (int i = 0; i < 10; i++)
       {
@@ -168,7 +171,7 @@ void Battery::postupdate()
       Game::add_particles(px, py, particle, 10);
     }
     Game::add_timer(entity, [entity = entity] { destroy_entity(entity); }, 30);
-    Level::Level::store(level_entity_id, "Collected", true);
+    Level::Level::store(level_entity_id, COLLECTED_FIELD, true);
   }
 
   light.intensity = lerp(light.intensity, 1.4f, 0.1f);
@@ -0,0 +1,688 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "level.hpp"
+#include "block.hpp"
+#include "hurtable.hpp"
+#include "level_loader.hpp"
+#include "manager.hpp"
+#include "physics.hpp"
+#include "physics_grid.hpp"
+
+[[nodiscard]] static double get_time()
+{
+  auto now = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(now.time_since_epoch()).count();
+}
+
+// Wall time of a call in seconds
+template<typename Function>
+[[nodiscard]] static double time_call(Function &&function)
+{
+  const double start = get_time();
+  function();
+  return get_time() - start;
+}
+
+// Results that differ from their reference in any benchmark, they make the benchmark fail in every build type
+static size_t mismatches = 0;
+
+static void report_mismatches(size_t row_mismatches)
+{
+  if (row_mismatches == 0)
+    return;
+
+  printf("  %zu results differ from the reference\n", row_mismatches);
+  mismatches += row_mismatches;
+}
+
+// Runs one row for every count, each in a level without entities. The row builds its scene, prints its timings and
+// returns how many of its results differ from the reference.
+template<typename Row>
+static void run_rows(std::span<const int> counts, Row &&row)
+{
+  for (const int count : counts)
+  {
+    destroy_non_persistent_entities();
+    report_mismatches(row(count));
+  }
+
+  destroy_non_persistent_entities();
+}
+
+static Physics &add_body(int x, int y, int w, int h)
+{
+  auto entity         = create_entity();
+  auto &physics       = add_component(entity, Physics()).get();
+  physics.x           = x;
+  physics.y           = y;
+  physics.mask.width  = w;
+  physics.mask.height = h;
+  return physics;
+}
+
+// Static solid tiles are laid out in rows with the same density as a level, so the world grows with the
+// tile count. A fixed number of dynamic bodies fall onto and slide along the first rows.
+static void benchmark_physics(int ticks)
+{
+  constexpr int TILE_SIZE      = 8;
+  constexpr int COLUMNS        = 110;
+  constexpr int ROW_SPACING    = 4;
+  constexpr int DYNAMIC_BODIES = 64;
+  constexpr int TILE_COUNTS[]  = { 100, 250, 500, 1000, 2000, 3000 };
+
+  auto &manager = Manager::get();
+
+  printf("%-8s %-8s %-10s %-12s %-12s\n", "tiles", "bodies", "cells", "us/tick", "us/body");
+
+  for (const int tile_count : TILE_COUNTS)
+  {
+    destroy_non_persistent_entities();
+
+    for (int i = 0; i < tile_count; i++)
+    {
+      const int column    = i % COLUMNS;
+      const int row       = i / COLUMNS;
+      auto &tile          = add_body(column * TILE_SIZE, (row + 1) * ROW_SPACING * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+      tile.solid          = true;
+      tile.movable        = false;
+      tile.do_update      = false;
+    }
+
+    for (int i = 0; i < DYNAMIC_BODIES; i++)
+    {
+      auto &body   = add_body(8 + (i * 13) % (COLUMNS * TILE_SIZE - 16), (i % 3) * TILE_SIZE, 6, 6);
+      body.gravity = 0.2f;
+      body.v.x     = (i % 2 == 0) ? 0.75f : -0.75f;
+    }
+
+    manager.call_init();
+
+    for (int i = 0; i < 10; i++)
+      manager.run_systems(Manager::Update);
+
+    const double start = get_time();
+    for (int i = 0; i < ticks; i++)
+      manager.run_systems(Manager::Update);
+    const double elapsed = get_time() - start;
+
+    const double us_per_tick = elapsed * 1e6 / ticks;
+    const size_t body_count  = get_components<Physics>().count;
+    printf("%-8d %-8zu %-10zu %-12.2f %-12.4f\n",
+           tile_count,
+           body_count,
+           PhysicsGrid::get().cell_count(),
+           us_per_tick,
+           us_per_tick / body_count);
+  }
+
+  destroy_non_persistent_entities();
+}
+
+// Looks up the Physics component of random entities through get_component and through a linear scan
+// over the component span, which is what get_component did before the entity index existed.
+static void benchmark_lookup(int lookups)
+{
+  constexpr int COMPONENT_COUNTS[] = { 100, 1000, 4000 };
+
+  printf("%-12s %-16s %-16s\n", "components", "ns/lookup", "ns/linear scan");
+
+  for (const int component_count : COMPONENT_COUNTS)
+  {
+    destroy_non_persistent_entities();
+
+    std::vector<Entity> entities;
+    entities.reserve(component_count);
+    for (int i = 0; i < component_count; i++)
+      entities.push_back(add_body(i, 0, 1, 1).entity);
+
+    // Remove and re-add a few bodies so the dense order no longer matches the entity order
+    for (int i = 0; i < component_count / 10; i++)
+    {
+      const auto entity = entities[(i * 7) % entities.size()];
+      destroy_entity(entity);
+      Manager::get().call_destroy();
+      entities[(i * 7) % entities.size()] = add_body(i, 0, 1, 1).entity;
+    }
+
+    std::vector<Entity> order(lookups);
+    uint32_t seed = 1;
+    for (auto &entity : order)
+    {
+      seed   = seed * 1664525u + 1013904223u;
+      entity = entities[seed % entities.size()];
+    }
+
+    // Both sums are printed, so the loops are not removed in release builds and the results can be compared
+    int64_t lookup_sum = 0;
+    int64_t scan_sum   = 0;
+
+    double start = get_time();
+    for (const auto entity : order)
+      lookup_sum += get_component<Physics>(entity).get().x;
+    const double lookup_time = get_time() - start;
+
+    start = get_time();
+    for (const auto entity : order)
+    {
+      for (const auto &physics : get_components<Physics>())
+      {
+        if (physics.entity == entity)
+        {
+          scan_sum += physics.x;
+          break;
+        }
+      }
+    }
+    const double scan_time = get_time() - start;
+
+    printf("%-12d %-16.2f %-16.2f (%lld/%lld)\n",
+           component_count,
+           lookup_time * 1e9 / lookups,
+           scan_time * 1e9 / lookups,
+           static_cast<long long>(lookup_sum),
+           static_cast<long long>(scan_sum));
+  }
+
+  destroy_non_persistent_entities();
+}
+
+// Existence checks of live and destroyed entities, and the cost of creating and destroying an entity
+static void benchmark_entities(int checks)
+{
+  constexpr int ENTITY_COUNTS[] = { 100, 1000, 4000 };
+
+  auto &manager = Manager::get();
+
+  printf("%-12s %-16s %-16s\n", "entities", "ns/exists", "ns/create+destroy");
+
+  const auto row = [&](int entity_count)
+  {
+    std::vector<Entity> entities;
+    entities.reserve(entity_count);
+    for (int i = 0; i < entity_count; i++)
+      entities.push_back(create_entity());
+
+    // Every tenth handle refers to a destroyed entity, whose slot is taken by a newer version
+    for (int i = 0; i < entity_count; i += 10)
+    {
+      destroy_entity(entities[i]);
+      manager.call_destroy();
+      (void)create_entity();
+    }
+
+    std::vector<Entity> order(checks);
+    size_t expected_existing = 0;
+    uint32_t seed            = 1;
+    for (auto &entity : order)
+    {
+      seed               = seed * 1664525u + 1013904223u;
+      const size_t index = seed % entities.size();
+      entity             = entities[index];
+      expected_existing += index % 10 != 0;
+    }
+
+    size_t existing          = 0;
+    const double exists_time = time_call(
+      [&]
+      {
+        for (const auto entity : order)
+          existing += entity_exists(entity);
+      });
+
+    const int cycles = std::max(1, checks / 100);
+    Entity cycled{ 0 };
+    const double cycle_time = time_call(
+      [&]
+      {
+        for (int i = 0; i < cycles; i++)
+        {
+          cycled = create_entity();
+          destroy_entity(cycled);
+          manager.call_destroy();
+        }
+      });
+
+    printf("%-12d %-16.2f %-16.2f (%zu)\n",
+           entity_count,
+           exists_time * 1e9 / checks,
+           cycle_time * 1e9 / cycles,
+           existing);
+
+    // Stale handles never match the newer entity in their slot, destroyed entities stop existing
+    const size_t existing_mismatches =
+      existing > expected_existing ? existing - expected_existing : expected_existing - existing;
+    return existing_mismatches + (entity_exists(cycled) ? 1 : 0);
+  };
+
+  run_rows(ENTITY_COUNTS, row);
+}
+
+// Destroys a level worth of entities at once, like leaving a room. Half of the entities are bodies with health,
+// the other half only have a body, so every type removes a different share of its components.
+static void benchmark_destroy(int rounds)
+{
+  constexpr int ENTITY_COUNTS[] = { 100, 1000, 3000 };
+  constexpr int SURVIVORS       = 4;
+
+  printf("%-12s %-16s %-16s\n", "entities", "us/destroy all", "ns/entity");
+
+  const auto row = [&](int entity_count)
+  {
+    // Persistent bodies between the entities of the first round survive every destroy, while the batched removal
+    // compacts the components around them
+    std::vector<Entity> survivors;
+    std::vector<ComponentReference<Physics>> survivor_bodies;
+    std::vector<ComponentReference<Hurtable>> survivor_hurtables;
+
+    size_t destroy_mismatches = 0;
+    double elapsed            = 0.0;
+    for (int round = 0; round < rounds; round++)
+    {
+      for (int i = 0; i < entity_count; i++)
+      {
+        auto &physics = add_body(i, 0, 1, 1);
+        if (i % 2 == 0)
+          add_component(physics.entity, Hurtable());
+
+        if (round == 0 && i % (entity_count / SURVIVORS) == 0)
+        {
+          const auto survivor = create_entity();
+          set_persistent(survivor);
+          survivors.push_back(survivor);
+          survivor_bodies.push_back(add_component(survivor, Physics()));
+          survivor_bodies.back().get().x = static_cast<int>(survivors.size());
+          survivor_hurtables.push_back(add_component(survivor, Hurtable()));
+        }
+      }
+
+      elapsed += time_call(destroy_non_persistent_entities);
+
+      destroy_mismatches += get_components<Physics>().count != survivors.size();
+      destroy_mismatches += get_components<Hurtable>().count != survivors.size();
+      for (size_t i = 0; i < survivors.size(); i++)
+      {
+        const bool body_valid =
+          survivor_bodies[i].get().entity == survivors[i] && survivor_bodies[i].get().x == static_cast<int>(i + 1);
+        const bool hurtable_valid = survivor_hurtables[i].get().entity == survivors[i];
+        destroy_mismatches += !entity_exists(survivors[i]) || !body_valid || !hurtable_valid;
+      }
+    }
+
+    for (const auto survivor : survivors)
+      unset_persistent(survivor);
+
+    printf("%-12d %-16.2f %-16.2f\n",
+           entity_count,
+           elapsed * 1e6 / rounds,
+           elapsed * 1e9 / rounds / entity_count);
+    return destroy_mismatches;
+  };
+
+  run_rows(ENTITY_COUNTS, row);
+}
+
+// Counts how often its entity was initialized
+struct InitCounter
+{
+  COMPONENT(InitCounter);
+
+  void init()
+  {
+    init_calls += 1;
+  }
+
+  int init_calls{ 0 };
+};
+
+REGISTER_COMPONENT(InitCounter);
+
+// A room of blocks is initialized once, then every frame adds a single body, like a fired bullet, and calls
+// call_init for it
+static void benchmark_init(int frames)
+{
+  constexpr int BLOCK_COUNTS[] = { 100, 1000, 3000 };
+
+  auto &manager = Manager::get();
+
+  printf("%-12s %-16s\n", "blocks", "us/call_init");
+
+  const auto row = [&](int block_count)
+  {
+    for (int i = 0; i < block_count; i++)
+    {
+      const auto block = create_entity();
+      add_component(block, Block(i * 8, 0, 8, 8));
+      add_component(block, InitCounter());
+    }
+    manager.call_init();
+
+    std::vector<Entity> bodies;
+    bodies.reserve(frames);
+
+    // Every pending component is initialized exactly once, however many call_init calls follow
+    size_t init_mismatches = 0;
+    double elapsed         = 0.0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+      auto &body = add_body(frame % 800, 16, 2, 2);
+      add_component(body.entity, InitCounter());
+      bodies.push_back(body.entity);
+
+      elapsed += time_call([&] { manager.call_init(); });
+
+      // Bodies are destroyed in batches, so the component count stays close to the room
+      if (bodies.size() == 16)
+      {
+        for (const auto entity : bodies)
+        {
+          init_mismatches += get_component<InitCounter>(entity).get().init_calls != 1;
+          destroy_entity(entity);
+        }
+        manager.call_destroy();
+        bodies.clear();
+      }
+    }
+
+    // Each block added its body once
+    for (const auto &counter : get_components<InitCounter>())
+      init_mismatches += counter.init_calls != 1;
+    init_mismatches += get_components<Physics>().count != static_cast<size_t>(block_count) + bodies.size();
+
+    printf("%-12d %-16.3f\n", block_count, elapsed * 1e6 / frames);
+    return init_mismatches;
+  };
+
+  run_rows(BLOCK_COUNTS, row);
+}
+
+// Copies the body position to the Hurtable of every entity that has both, through a view and through the
+// get_component lookups the gameplay postupdates did. Only every fourth body is hurtable, like in a level where
+// most bodies are tiles.
+static void benchmark_view(int passes)
+{
+  constexpr int BODY_COUNTS[] = { 100, 1000, 3000 };
+
+  printf("%-12s %-12s %-16s %-16s\n", "bodies", "hurtables", "ns/view", "ns/lookups");
+
+  const auto row = [&](int body_count)
+  {
+    std::vector<Entity> hurtable_entities;
+    for (int i = 0; i < body_count; i++)
+    {
+      auto &physics = add_body(i, i / 2, 1, 1);
+      if (i % 4 == 0)
+      {
+        add_component(physics.entity, Hurtable());
+        hurtable_entities.push_back(physics.entity);
+      }
+    }
+
+    // Both sums are printed, so the loops are not removed in release builds and the results can be compared
+    long long view_sum   = 0;
+    long long lookup_sum = 0;
+
+    const double view_time = time_call(
+      [&]
+      {
+        for (int pass = 0; pass < passes; pass++)
+        {
+          for (auto [physics, hurtable] : view<Physics, Hurtable>())
+          {
+            hurtable.hit_point_x = physics.x + pass;
+            view_sum += hurtable.hit_point_x;
+          }
+        }
+      });
+
+    const double lookup_time = time_call(
+      [&]
+      {
+        for (int pass = 0; pass < passes; pass++)
+        {
+          for (const auto entity : hurtable_entities)
+          {
+            auto &physics        = get_component<Physics>(entity).get();
+            auto &hurtable       = get_component<Hurtable>(entity).get();
+            hurtable.hit_point_x = physics.x + pass;
+            lookup_sum += hurtable.hit_point_x;
+          }
+        }
+      });
+
+    const double visits = static_cast<double>(hurtable_entities.size()) * passes;
+    printf("%-12d %-12zu %-16.2f %-16.2f (%lld/%lld)\n",
+           body_count,
+           hurtable_entities.size(),
+           view_time * 1e9 / visits,
+           lookup_time * 1e9 / visits,
+           view_sum,
+           lookup_sum);
+
+    // The view visits every entity that has both components once, and no other entity
+    std::vector<Entity> visited;
+    for (auto [physics, hurtable] : view<Physics, Hurtable>())
+    {
+      visited.push_back(physics.entity);
+      if (hurtable.entity != physics.entity)
+        visited.push_back(hurtable.entity);
+    }
+
+    std::sort(visited.begin(), visited.end());
+    std::sort(hurtable_entities.begin(), hurtable_entities.end());
+
+    std::vector<Entity> differences;
+    std::set_symmetric_difference(visited.begin(),
+                                  visited.end(),
+                                  hurtable_entities.begin(),
+                                  hurtable_entities.end(),
+                                  std::back_inserter(differences));
+    return differences.size() + (view_sum != lookup_sum ? 1 : 0);
+  };
+
+  run_rows(BODY_COUNTS, row);
+}
+
+[[nodiscard]] static size_t resident_memory()
+{
+  size_t pages    = 0;
+  size_t resident = 0;
+  if (FILE *file = fopen("/proc/self/statm", "r"))
+  {
+    if (fscanf(file, "%zu %zu", &pages, &resident) != 2)
+      resident = 0;
+    fclose(file);
+  }
+
+  return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Resident memory of the component storage and throughput of iterating over a component span
+static void benchmark_storage(int passes)
+{
+  constexpr int COMPONENT_COUNTS[] = { 100, 1000, 4000 };
+
+  auto &physics_manager = Manager::get().component_containers[Physics::id()].get_manager<Physics>();
+
+  printf("storage: %s, resident memory after registration: %.2f MB\n",
+#if defined(PACKED_COMPONENTS)
+         "packed",
+#else
+         "padded",
+#endif
+         resident_memory() / (1024.0 * 1024.0));
+  printf("%-12s %-16s %-16s %-16s\n", "components", "storage KB", "resident MB", "M components/s");
+
+  for (const int component_count : COMPONENT_COUNTS)
+  {
+    destroy_non_persistent_entities();
+
+    for (int i = 0; i < component_count; i++)
+      add_body(i, i / 2, 1, 1);
+
+    int64_t checksum = 0;
+
+    const double start = get_time();
+    for (int pass = 0; pass < passes; pass++)
+      for (const auto &physics : get_components<Physics>())
+        checksum += physics.x + physics.y;
+    const double elapsed = get_time() - start;
+
+    printf("%-12d %-16.1f %-16.2f %-16.1f (%lld)\n",
+           component_count,
+           physics_manager.memory_usage() / 1024.0,
+           resident_memory() / (1024.0 * 1024.0),
+           static_cast<double>(component_count) * passes / elapsed / 1e6,
+           static_cast<long long>(checksum));
+  }
+
+  destroy_non_persistent_entities();
+}
+
+// Constructs the field-heavy level entities of every level through the level registry, which is what
+// Level::create_entities does, and reads the persistent fields their init() reads
+static void benchmark_fields(int rounds)
+{
+  constexpr const char *ENTITY_NAMES[] = { "Terminal", "Enemy" };
+
+  LevelLoader::load_project();
+
+  std::vector<Level::Entity> definitions;
+  for (const auto &name : LevelLoader::get_level_names())
+  {
+    LevelLoader level_loader(name);
+    for (const auto &[_, entity] : level_loader.entities)
+    {
+      if (std::find(std::begin(ENTITY_NAMES), std::end(ENTITY_NAMES), entity.name) != std::end(ENTITY_NAMES))
+        definitions.push_back(entity);
+    }
+  }
+
+  auto &entity_registry   = Level::LevelRegistry::get();
+  const auto killed_field = Level::field_id("Killed");
+
+  // Every other entity has a stored flag, like killed enemies
+  for (size_t i = 0; i < definitions.size(); i += 2)
+    Level::Level::store(definitions[i].id, killed_field, true);
+
+  double construct_time = 0.0;
+  double store_time     = 0.0;
+  size_t found          = 0;
+
+  for (int round = 0; round < rounds; round++)
+  {
+    destroy_non_persistent_entities();
+
+    std::vector<Entity> entities(definitions.size());
+    for (auto &entity : entities)
+      entity = create_entity();
+
+    construct_time += time_call(
+      [&]
+      {
+        for (size_t i = 0; i < definitions.size(); i++)
+          entity_registry.find(definitions[i].type)(definitions[i], entities[i]);
+      });
+
+    store_time += time_call(
+      [&]
+      {
+        for (const auto &definition : definitions)
+        {
+          Level::Field field;
+          Level::Level::load(definition.id, killed_field, field);
+          found += std::holds_alternative<bool>(field);
+        }
+      });
+  }
+
+  destroy_non_persistent_entities();
+
+  // Exactly the flags stored above are found, with the stored value
+  size_t field_mismatches = 0;
+  for (size_t i = 0; i < definitions.size(); i++)
+  {
+    Level::Field field;
+    Level::Level::load(definitions[i].id, killed_field, field);
+    const bool killed = std::holds_alternative<bool>(field) && std::get<bool>(field);
+    field_mismatches += killed != (i % 2 == 0);
+  }
+
+  const double constructions = static_cast<double>(definitions.size()) * rounds;
+  printf("%-10s %-16s %-16s %-10s\n", "entities", "ns/construct", "ns/store read", "stored");
+  printf("%-10zu %-16.1f %-16.1f %-10zu\n",
+         definitions.size(),
+         construct_time * 1e9 / constructions,
+         store_time * 1e9 / constructions,
+         found / rounds);
+  report_mismatches(field_mismatches);
+}
+
+int main(int argc, char **argv)
+{
+  const std::string_view name = argc > 1 ? argv[1] : "all";
+  const int ticks             = argc > 2 ? std::max(1, std::atoi(argv[2])) : 600;
+
+  if (name == "physics" || name == "all")
+  {
+    printf("== physics (%d ticks)\n", ticks);
+    benchmark_physics(ticks);
+  }
+
+  if (name == "entities" || name == "all")
+  {
+    printf("== entities (%d checks)\n", ticks * 100);
+    benchmark_entities(ticks * 100);
+  }
+
+  if (name == "destroy" || name == "all")
+  {
+    printf("== destroy (%d rounds)\n", ticks);
+    benchmark_destroy(ticks);
+  }
+
+  if (name == "init" || name == "all")
+  {
+    printf("== init (%d frames)\n", ticks * 10);
+    benchmark_init(ticks * 10);
+  }
+
+  if (name == "storage" || name == "all")
+  {
+    printf("== storage (%d passes)\n", ticks);
+    benchmark_storage(ticks);
+  }
+
+  if (name == "lookup" || name == "all")
+  {
+    printf("== lookup (%d lookups)\n", ticks * 100);
+    benchmark_lookup(ticks * 100);
+  }
+
+  if (name == "view" || name == "all")
+  {
+    printf("== view (%d passes)\n", ticks);
+    benchmark_view(ticks);
+  }
+
+  if (name == "fields" || name == "all")
+  {
+    printf("== fields (%d rounds)\n", ticks);
+    benchmark_fields(ticks);
+  }
+
+  if (mismatches > 0)
+  {
+    printf("%zu results differ from the reference\n", mismatches);
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
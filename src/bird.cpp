@@ -24,7 +24,8 @@ void Bird::init()
   physics.x     = start_x;
   physics.y     = start_y;
 
-  auto &renderer = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
+  auto &renderer          = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
+  renderer.follow_physics = true;
   renderer.set_position(start_x, start_y);
   auto &sprite           = renderer.sprite_interpolated.sprite;
   sprite.source_offset.x = 0.0f;
@@ -87,7 +88,6 @@ void Bird::postupdate()
 {
   auto &renderer = get_component<SpriteRenderer>(entity).get();
   auto &physics  = get_component<Physics>(entity).get();
-  renderer.set_position(physics.x, physics.y);
 
   if (fabs(physics.v.x) > 0.2f || fabs(physics.v.y) > 0.1f)
     renderer.sprite_interpolated.sprite.set_tag("fly");
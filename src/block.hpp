@@ -26,6 +26,15 @@ struct Block
   {
   }
 
+  Block(int x, int y, int w, int h, bool oneway = false)
+    : x{ x }
+    , y{ y }
+    , w{ w }
+    , h{ h }
+    , oneway{ oneway }
+  {
+  }
+
   void init()
   {
     auto &physics       = add_component(entity, Physics()).get();
@@ -34,6 +43,7 @@ struct Block
     physics.mask.width  = w;
     physics.mask.height = h;
     physics.solid       = true;
+    physics.oneway      = oneway;
     physics.movable     = false;
     physics.do_update   = false;
   }
@@ -43,4 +53,5 @@ private:
   int y{ 0 };
   int w{ 0 };
   int h{ 0 };
+  bool oneway{ false };
 };
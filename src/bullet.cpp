@@ -20,8 +20,9 @@ void Bullet::init()
   physics.solid = false;
   physics.mask  = Mask::center_rect(8, 6);
 
-  auto &renderer = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
-  auto &sprite   = renderer.sprite_interpolated.sprite;
+  auto &renderer          = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
+  renderer.follow_physics = true;
+  auto &sprite            = renderer.sprite_interpolated.sprite;
   sprite.set_frame_count(1);
   sprite.source_offset.x = 0;
   sprite.source_offset.y = 216;
@@ -59,10 +60,7 @@ void Bullet::update()
 
 void Bullet::postupdate()
 {
-  auto &physics  = get_component<Physics>(entity).get();
-  auto &renderer = get_component<SpriteRenderer>(entity).get();
-
-  renderer.set_position(physics.x, physics.y);
+  auto &physics = get_component<Physics>(entity).get();
 
   const auto &level_width  = Game::level_width();
   const auto &level_height = Game::level_height();
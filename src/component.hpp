@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
 #include <set>
 #include <string>
 #include <utility>
@@ -12,8 +17,9 @@ using Entity        = std::uint64_t;
 using EntitySet     = std::set<Entity>;
 using LevelEntityId = std::string;
 
-constexpr inline Entity INVALID_ENTITY         = 0;
-constexpr inline size_t COMPONENT_PADDING_SIZE = 1024;
+constexpr inline Entity INVALID_ENTITY          = 0;
+constexpr inline size_t COMPONENT_PADDING_SIZE  = 1024;
+constexpr inline size_t MAX_COMPONENTS_PER_TYPE = 4096;
 
 using ComponentType = std::uint64_t;
 
@@ -51,12 +57,155 @@ private:
   std::byte pad[COMPONENT_PADDING_SIZE > sizeof(C) ? COMPONENT_PADDING_SIZE - sizeof(C) : 1]{};
 };
 
+#if defined(PACKED_COMPONENTS)
+// Components stored at their natural size in fixed-size chunks, allocated as the count grows.
+// Chunks never move, so component addresses stay valid while other components are added.
 template<typename C>
-struct ComponentsSpan
+struct ComponentStorage
 {
-  ComponentPadded<C> *const components;
-  const size_t count;
+  static constexpr size_t CHUNK_SHIFT = 7;
+  static constexpr size_t CHUNK_SIZE  = size_t{ 1 } << CHUNK_SHIFT;
+  static constexpr size_t CHUNK_MASK  = CHUNK_SIZE - 1;
 
+  struct Iterator
+  {
+    using value_type = C;
+    using pointer    = C *;
+    using reference  = C &;
+
+    const ComponentStorage *storage;
+    size_t chunk_index;
+    C *ptr;
+    C *chunk_end;
+
+    Iterator &operator++()
+    {
+      if (++ptr == chunk_end)
+      {
+        chunk_index += 1;
+        ptr       = storage->chunk(chunk_index);
+        chunk_end = ptr ? ptr + CHUNK_SIZE : nullptr;
+      }
+      return *this;
+    }
+
+    [[nodiscard]] bool operator!=(const Iterator &other) const
+    {
+      return ptr != other.ptr;
+    }
+
+    [[nodiscard]] C &operator*() const
+    {
+      return *ptr;
+    }
+
+    [[nodiscard]] C *operator->() const
+    {
+      return ptr;
+    }
+  };
+
+  [[nodiscard]] inline C &operator[](size_t index) const
+  {
+    assert((index >> CHUNK_SHIFT) < chunks.size() && "Component index out of storage");
+    return reinterpret_cast<C *>(chunks[index >> CHUNK_SHIFT])[index & CHUNK_MASK];
+  }
+
+  [[nodiscard]] inline C *chunk(size_t chunk_index) const
+  {
+    return chunk_index < chunks.size() ? reinterpret_cast<C *>(chunks[chunk_index]) : nullptr;
+  }
+
+  [[nodiscard]] inline Iterator iterator(size_t index) const
+  {
+    const size_t chunk_index = index >> CHUNK_SHIFT;
+    C *base                  = chunk(chunk_index);
+    if (!base)
+      return { this, chunk_index, nullptr, nullptr };
+
+    return { this, chunk_index, base + (index & CHUNK_MASK), base + CHUNK_SIZE };
+  }
+
+  [[nodiscard]] inline size_t capacity() const
+  {
+    return chunks.size() * CHUNK_SIZE;
+  }
+
+  [[nodiscard]] inline size_t memory_usage() const
+  {
+    return chunks.size() * CHUNK_SIZE * element_size;
+  }
+
+  // Slots are constructed on first use and afterwards reused by move assignment, like the padded storage
+  void assign(size_t index, C &&component)
+  {
+    while (index >= capacity())
+      chunks.push_back(allocate_chunk(sizeof(C)));
+
+    if (index < constructed)
+    {
+      (*this)[index] = std::move(component);
+      return;
+    }
+
+    assert(index == constructed && "Component slots must be constructed in order");
+    new (&(*this)[index]) C(std::move(component));
+    constructed += 1;
+  }
+
+  void swap(size_t a, size_t b)
+  {
+    std::swap((*this)[a], (*this)[b]);
+  }
+
+  // A reloaded library may have changed the component layout. Component bytes are carried over at the same
+  // offsets, which is what the padded slots did implicitly.
+  void restride()
+  {
+    if (element_size == sizeof(C) && element_alignment == alignof(C))
+      return;
+
+    printf("Component layout changed from %zu to %zu bytes (alignment %zu to %zu), restriding storage\n",
+           element_size,
+           sizeof(C),
+           element_alignment,
+           alignof(C));
+
+    const auto old_chunks = std::move(chunks);
+    const auto old_size   = element_size;
+    chunks.clear();
+
+    for (size_t i = 0; i < old_chunks.size(); i++)
+    {
+      auto *new_chunk = allocate_chunk(sizeof(C));
+      std::memset(new_chunk, 0, CHUNK_SIZE * sizeof(C));
+      for (size_t j = 0; j < CHUNK_SIZE; j++)
+        std::memcpy(new_chunk + j * sizeof(C), old_chunks[i] + j * old_size, std::min(old_size, sizeof(C)));
+
+      // Old chunks were allocated with the alignment of the previous layout
+      ::operator delete(old_chunks[i], std::align_val_t{ element_alignment });
+      chunks.push_back(new_chunk);
+    }
+
+    element_size      = sizeof(C);
+    element_alignment = alignof(C);
+  }
+
+private:
+  [[nodiscard]] static std::byte *allocate_chunk(size_t size)
+  {
+    return static_cast<std::byte *>(::operator new(CHUNK_SIZE * size, std::align_val_t{ alignof(C) }));
+  }
+
+  std::vector<std::byte *> chunks;
+  size_t constructed{ 0 };
+  size_t element_size{ sizeof(C) };
+  size_t element_alignment{ alignof(C) };
+};
+#else
+template<typename C>
+struct ComponentStorage
+{
   struct Iterator
   {
     using value_type = C;
@@ -87,6 +236,55 @@ struct ComponentsSpan
     }
   };
 
+  [[nodiscard]] inline C &operator[](size_t index) const
+  {
+    return const_cast<ComponentPadded<C> &>(components[index]).component;
+  }
+
+  [[nodiscard]] inline Iterator iterator(size_t index) const
+  {
+    return { const_cast<ComponentPadded<C> *>(components.data()) + index };
+  }
+
+  [[nodiscard]] inline size_t capacity() const
+  {
+    return components.size();
+  }
+
+  [[nodiscard]] inline size_t memory_usage() const
+  {
+    return sizeof(components);
+  }
+
+  void assign(size_t index, C &&component)
+  {
+    static_assert(sizeof(C) < COMPONENT_PADDING_SIZE);
+    static_assert(sizeof(ComponentPadded<C>) == COMPONENT_PADDING_SIZE);
+    components[index] = std::move(component);
+  }
+
+  void swap(size_t a, size_t b)
+  {
+    std::swap(components[a], components[b]);
+  }
+
+  void restride()
+  {
+  }
+
+private:
+  std::array<ComponentPadded<C>, MAX_COMPONENTS_PER_TYPE> components;
+};
+#endif
+
+template<typename C>
+struct ComponentsSpan
+{
+  const ComponentStorage<C> *const storage;
+  const size_t count;
+
+  using Iterator = typename ComponentStorage<C>::Iterator;
+
   [[nodiscard]] inline bool empty() const noexcept
   {
     return count == 0;
@@ -94,29 +292,29 @@ struct ComponentsSpan
 
   [[nodiscard]] inline Iterator begin() const noexcept
   {
-    return { components };
+    return storage->iterator(0);
   }
 
   [[nodiscard]] inline Iterator end() const noexcept
   {
-    return { components + count };
+    return storage->iterator(count);
   }
 
   [[nodiscard]] inline C &front() const noexcept
   {
     assert(count > 0 && "ComponentsSpan is empty");
-    return components->component;
+    return (*storage)[0];
   }
 
   [[nodiscard]] inline C &back() const noexcept
   {
     assert(count > 0 && "ComponentsSpan is empty");
-    return (components + count - 1)->component;
+    return (*storage)[count - 1];
   }
 
   [[nodiscard]] inline C &operator[](size_t index) const noexcept
   {
     assert(index < count && "Index out of bounds");
-    return (components + index)->component;
+    return (*storage)[index];
   }
 };
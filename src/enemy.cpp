@@ -15,6 +15,10 @@ REGISTER_COMPONENT(Enemy);
 COMPONENT_TEMPLATE(Enemy);
 REGISTER_LEVEL_ENTITY(Enemy);
 
+static const Level::FieldId TYPE_FIELD       = Level::field_id("Type");
+static const Level::FieldId IDENTIFIER_FIELD = Level::field_id("Identifier");
+static const Level::FieldId KILLED_FIELD     = Level::field_id("Killed");
+
 Enemy::Enemy(int x, int y, Enemy::Type enemy_type)
   : start_x{ x }
   , start_y{ y }
@@ -30,14 +34,14 @@ Enemy::Enemy(const Level::Entity &entity)
   start_y = entity.position.y + entity.size.h / 2;
 
   std::string type_str;
-  try_read_field(entity.fields, "Type", type_str);
+  try_read_field(entity.fields, TYPE_FIELD, type_str);
 
   if (auto type_val = magic_enum::enum_cast<Type>(type_str))
     this->type = type_val.value();
   else
     fprintf(stderr, "Unknown enemy type '%s'\n", type_str.c_str());
 
-  read_field(entity.fields, "Identifier", level_entity_id);
+  read_field(entity.fields, IDENTIFIER_FIELD, level_entity_id);
 }
 
 void Enemy::init()
@@ -50,8 +54,9 @@ void Enemy::init()
 
   auto &hurtable = add_component(entity, Hurtable()).get();
 
-  auto &renderer = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
-  auto &sprite   = renderer.sprite_interpolated.sprite;
+  auto &renderer          = add_component(entity, SpriteRenderer("assets/tileset.png")).get();
+  renderer.follow_physics = true;
+  auto &sprite            = renderer.sprite_interpolated.sprite;
 
   death_sound = GameSound("assets/sounds/boom2.wav");
   death_sound.set_volume(2.0f);
@@ -157,7 +162,7 @@ void Enemy::init()
   add_component(entity, Light());
 
   Level::Field killed_field;
-  Level::Level::load(level_entity_id, "Killed", killed_field);
+  Level::Level::load(level_entity_id, KILLED_FIELD, killed_field);
 
   if (auto killed = std::get_if<bool>(&killed_field); killed && *killed)
   {
@@ -409,8 +414,6 @@ void Enemy::postupdate()
   auto &renderer = get_component<SpriteRenderer>(entity).get();
   auto &hurtable = get_component<Hurtable>(entity).get();
 
-  renderer.set_position(physics.x, physics.y);
-
   if (type == Type::Slime)
   {
     if (fabs(physics.v.x) < 0.1f)
@@ -444,7 +447,7 @@ void Enemy::postupdate()
     {
       death_sound.play();
 
-      Level::Level::store(level_entity_id, "Killed", true);
+      Level::Level::store(level_entity_id, KILLED_FIELD, true);
 
       light.size      = 2.0f;
       light.intensity = 5.0f;
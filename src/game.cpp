@@ -10,14 +10,27 @@
 #include "hurtable.hpp"
 #include "input.hpp"
 #include "level.hpp"
+#include "level_streamer.hpp"
 #include "light.hpp"
 #include "manager.hpp"
 #include "player.hpp"
 #include "renderers.hpp"
+#include "room_cache.hpp"
 #include "utils.hpp"
+#include "worker_pool.hpp"
+#include "world_streamer.hpp"
 
 static Game *game{ nullptr };
 
+// Renderers are culled against the camera rectangle grown by this margin
+static constexpr float RENDER_VIEW_MARGIN = 16.0f;
+
+#if defined(HEADLESS)
+// Size of the engine's game render texture
+static constexpr int HEADLESS_VIEW_WIDTH  = 320;
+static constexpr int HEADLESS_VIEW_HEIGHT = 180;
+#endif
+
 extern "C"
 {
   void G_create_game()
@@ -80,6 +93,18 @@ extern "C"
 #endif
   }
 
+#if defined(HEADLESS)
+  void G_load_level(const char *name)
+  {
+    assert(game && "Game is not created");
+
+    game->level.reset_player_position = true;
+    game->level.load(name);
+    game->particle_system.get().clear();
+    Manager::get().call_init();
+  }
+#endif
+
   void G_reload_game()
   {
     CloseAudioDevice();
@@ -99,6 +124,15 @@ extern "C"
       timer.callback();
     game->timers.clear();
 
+    // The streaming thread and the system workers run code of this library
+    Level::LevelStreamer::get().stop();
+    WorkerPool::get().stop();
+
+    // Resident and cached rooms hold components of this library
+    Level::WorldStreamer::get().clear();
+    Level::RoomCache::get().clear();
+    Manager::get().call_destroy();
+
     auto &manager = Manager::get();
     manager.unregister_all();
   }
@@ -196,37 +230,15 @@ extern "C"
       game.generate_palette_texture();
     }
 
-    auto players     = get_components<Player>();
-    bool move_camera = true;
-#if defined(DEBUG)
-    if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON))
-      move_camera = false;
-#endif
-    if (!players.empty() && move_camera)
+    auto players = get_components<Player>();
+    if (game.level.stream_world)
     {
-      const auto &player   = players.front();
-      auto &player_physics = get_component<Physics>(player.entity).get();
-      auto &player_x       = player_physics.x;
-      auto &player_y       = player_physics.y;
-      camera.offset        = { game.render_texture.value.texture.width / 2.0f,
-                               game.render_texture.value.texture.height / 2.0f };
-      camera.target.x      = player_x - player_physics.mask.width / 2;
-      camera.target.y      = player_y - player_physics.mask.height / 2;
-      camera.target.x      = roundf(camera.target.x);
-      camera.target.y      = roundf(camera.target.y);
-
-      if (camera.target.x < camera.offset.x)
-        camera.target.x = camera.offset.x;
-      if (camera.target.y < camera.offset.y)
-        camera.target.y = camera.offset.y;
-      if (camera.target.x > game.level.get_width() - camera.offset.x)
-        camera.target.x = game.level.get_width() - camera.offset.x;
-      if (camera.target.y > game.level.get_height() - camera.offset.y)
-        camera.target.y = game.level.get_height() - camera.offset.y;
-
-      camera.zoom     = 1.0f;
-      camera.rotation = 0.0f;
+      Level::WorldStreamer::get().update(Rectangle{ camera.target.x - camera.offset.x,
+                                                    camera.target.y - camera.offset.y,
+                                                    static_cast<float>(game.render_texture.value.texture.width),
+                                                    static_cast<float>(game.render_texture.value.texture.height) });
     }
+    game.update_camera();
 
     // map variables
     static auto tileset        = LoadTexture("assets/tileset.png");
@@ -261,6 +273,12 @@ extern "C"
       SetShaderValueTexture(shader, GetShaderLocation(shader, "texture1"), tileset_normal);
       SetShaderValueTexture(shader, GetShaderLocation(shader, "texture2"), game.palette_texture);
 
+      manager.set_render_view(camera.target.x - camera.offset.x,
+                              camera.target.y - camera.offset.y,
+                              game.render_texture.value.texture.width,
+                              game.render_texture.value.texture.height,
+                              RENDER_VIEW_MARGIN);
+
       BeginMode2D(camera);
       {
         manager.call_render();
@@ -303,6 +321,17 @@ extern "C"
       DrawTexture(game.palette_texture, 2, 2, FULLWHITE);
       DrawTextEx(
         game.font, TextFormat("Lights: %zu", light_idx), { 2, 12 }, game.font_size, game.font_spacing, PALETTE_YELLOW);
+
+      const auto &render_stats = manager.get_render_stats();
+      DrawTextEx(game.font,
+                 TextFormat("Commands: %zu (culled: %zu, sort: %.3f ms)",
+                            render_stats.command_count,
+                            render_stats.culled_count,
+                            render_stats.sort_time * 1000.0),
+                 { 2, 12 + game.font_size },
+                 game.font_size,
+                 game.font_spacing,
+                 PALETTE_YELLOW);
 #endif
     }
     EndTextureMode();
@@ -585,6 +614,13 @@ extern "C"
   {
     assert(game && "Game is not created");
 
+    PROFILE_SCOPE("tick");
+
+#if defined(HEADLESS)
+    // Nothing is drawn, but entities still check visibility against the camera of the previous tick
+    game->update_camera();
+#endif
+
     game->ticks += 1;
 
     auto &manager = Manager::get();
@@ -707,6 +743,7 @@ extern "C"
     if (INPUT.mute.pressed())
       game->mute = !game->mute;
 
+#if !defined(HEADLESS)
     if (!game->mute && game->track != Game::MusicTrack::None)
     {
       Music &music = game->music;
@@ -732,9 +769,16 @@ extern "C"
     {
       StopMusicStream(game->music);
     }
+#endif
 
-    manager.call_destroy();
-    manager.call_init();
+    {
+      PROFILE_SCOPE("destroy");
+      manager.call_destroy();
+    }
+    {
+      PROFILE_SCOPE("init");
+      manager.call_init();
+    }
 
     if (game->skip_ticks_count > 0)
     {
@@ -777,25 +821,17 @@ extern "C"
         return;
       }
 
-      for (auto &component_id : manager.preupdate_components)
       {
-        auto &container = manager.component_containers[component_id];
-        if (container.preupdate)
-          container.preupdate();
+        PROFILE_SCOPE("preupdate");
+        manager.run_systems(Manager::Preupdate);
       }
-
-      for (auto &component_id : manager.update_components)
       {
-        auto &container = manager.component_containers[component_id];
-        if (container.update)
-          container.update();
+        PROFILE_SCOPE("update");
+        manager.run_systems(Manager::Update);
       }
-
-      for (auto &component_id : manager.postupdate_components)
       {
-        auto &container = manager.component_containers[component_id];
-        if (container.postupdate)
-          container.postupdate();
+        PROFILE_SCOPE("postupdate");
+        manager.run_systems(Manager::Postupdate);
       }
     }
     else
@@ -804,6 +840,12 @@ extern "C"
     }
 
 #if defined(DEBUG)
+    if (IsKeyPressed(KEY_V))
+    {
+      game->level.stream_world = !game->level.stream_world;
+      printf("World streaming %s\n", game->level.stream_world ? "enabled" : "disabled");
+      game->level.reload();
+    }
     if (IsKeyPressed(KEY_B))
     {
       game->show_map = !game->show_map;
@@ -822,7 +864,10 @@ extern "C"
 
     game->update_map();
 
-    manager.call_init();
+    {
+      PROFILE_SCOPE("init");
+      manager.call_init();
+    }
 
     game->update_timers();
   }
@@ -836,8 +881,56 @@ Game &Game::get()
 
 Game::Game() {}
 
+void Game::update_camera()
+{
+  auto players     = get_components<Player>();
+  bool move_camera = true;
+#if defined(DEBUG)
+  if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON))
+    move_camera = false;
+#endif
+  if (!players.empty() && move_camera)
+  {
+    const auto &player   = players.front();
+    auto &player_physics = get_component<Physics>(player.entity).get();
+    auto &player_x       = player_physics.x;
+    auto &player_y       = player_physics.y;
+    camera.offset        = { render_texture.value.texture.width / 2.0f, render_texture.value.texture.height / 2.0f };
+    camera.target.x      = player_x - player_physics.mask.width / 2;
+    camera.target.y      = player_y - player_physics.mask.height / 2;
+    camera.target.x      = roundf(camera.target.x);
+    camera.target.y      = roundf(camera.target.y);
+
+    // Streamed worlds can scroll into the rooms around the current one
+    Rectangle bounds{ 0.0f, 0.0f, static_cast<float>(level.get_width()), static_cast<float>(level.get_height()) };
+    if (level.stream_world)
+    {
+      const Vector2 view_size{ camera.offset.x * 2.0f, camera.offset.y * 2.0f };
+      bounds = Level::WorldStreamer::get().get_bounds(camera.target, view_size);
+    }
+
+    if (camera.target.x < bounds.x + camera.offset.x)
+      camera.target.x = bounds.x + camera.offset.x;
+    if (camera.target.y < bounds.y + camera.offset.y)
+      camera.target.y = bounds.y + camera.offset.y;
+    if (camera.target.x > bounds.x + bounds.width - camera.offset.x)
+      camera.target.x = bounds.x + bounds.width - camera.offset.x;
+    if (camera.target.y > bounds.y + bounds.height - camera.offset.y)
+      camera.target.y = bounds.y + bounds.height - camera.offset.y;
+
+    camera.zoom     = 1.0f;
+    camera.rotation = 0.0f;
+  }
+}
+
 void Game::init()
 {
+#if defined(HEADLESS)
+  // No window or audio device, only the view size used by the camera and visibility checks is set up
+  render_texture.resize(HEADLESS_VIEW_WIDTH, HEADLESS_VIEW_HEIGHT);
+#else
+  map_texture = LoadTexture("assets/map.png");
+
   music_tracks[AreaZero] = LoadMusicStream("assets/music/place-stay.mp3");
   SetMusicVolume(music_tracks[AreaZero], 0.5f);
 
@@ -895,6 +988,7 @@ void Game::init()
 #endif
 
   assert(IsFontValid(font) && "Font is not valid");
+#endif
 
   char_sound   = GameSound("assets/sounds/blip.wav");
   select_sound = GameSound("assets/sounds/blip2.wav");
@@ -1071,6 +1165,11 @@ void Game::generate_palette_texture()
   UnloadImage(palette_image);
 }
 
+const Shader &Game::world_shader()
+{
+  return get().dither_fx.shader.shader;
+}
+
 int64_t Game::level_width()
 {
   return get().level.get_width();
@@ -1248,6 +1347,12 @@ void Game::update_messages()
     }
   }
 
+#if defined(HEADLESS)
+  // Text messages wait for a key press, nobody is there to dismiss them in headless runs
+  messages.pop();
+  return;
+#endif
+
   static int max_delay         = 4;
   static bool skipping_message = false;
   if (!message_ready && action_pressed)
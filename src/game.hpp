@@ -13,6 +13,7 @@
 #include "component.hpp"
 #include "level.hpp"
 #include "particles.hpp"
+#include "profiler.hpp"
 #include "rl_utils.hpp"
 
 extern "C"
@@ -23,6 +24,10 @@ extern "C"
   void G_reload_game();
   void G_unload_game();
   void G_update_game();
+
+#if defined(HEADLESS)
+  void G_load_level(const char *name);
+#endif
 };
 
 constexpr const inline Color PALETTE[8]{ Color{ 0, 0, 0, 255 },       Color{ 85, 65, 95, 255 },
@@ -54,6 +59,7 @@ struct Game final
   [[nodiscard]] static size_t frame();
   static void skip_ticks(size_t count);
   [[nodiscard]] static bool on_screen(Rectangle rect);
+  [[nodiscard]] static const Shader &world_shader();
   static void defer_draw(Entity entity, std::function<void()> &&callback);
   static void queue_message(std::string message, Color color = PALETTE_WHITE);
   static void end_level();
@@ -79,6 +85,7 @@ private:
 
   void init();
   void draw();
+  void update_camera();
 
   struct Values
   {
@@ -155,7 +162,7 @@ private:
   int map_x = 400;
   int map_y = 6;
   size_t selected_map_node{ 0 };
-  Texture map_texture{ LoadTexture("assets/map.png") };
+  Texture map_texture{};
   void load_selected_level();
   int defeated_frames{ 0 };
   int defeated_max_frames{ 60 };
@@ -170,6 +177,9 @@ private:
   friend void G_unload_game();
   friend void G_update_game();
   friend void G_draw_game(double, RenderTexture &, RenderTexture &);
+#if defined(HEADLESS)
+  friend void G_load_level(const char *);
+#endif
 
   bool debug_auto_shader_reload{ false };
 };
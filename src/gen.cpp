@@ -139,6 +139,8 @@ void generate_entity(const std::string &component_name, const std::string &file_
       if (params.has_sprite_renderer)
       {
         file << "  auto &renderer = add_component(entity, SpriteRenderer()).get();\n";
+        if (params.has_postupdate_update_position && params.has_physics)
+          file << "  renderer.follow_physics = true;\n";
         if (params.is_level_entity)
         {
           file << "  renderer.set_position(start_x, start_y);\n";
@@ -192,16 +194,6 @@ void generate_entity(const std::string &component_name, const std::string &file_
     {
       file << "void " << component_name << "::postupdate()\n";
       file << "{\n";
-      if (params.has_postupdate_update_position)
-      {
-        if (params.has_sprite_renderer)
-          file << "  auto &renderer = get_component<SpriteRenderer>(entity).get();\n";
-        if (params.has_physics)
-        {
-          file << "  auto &physics = get_component<Physics>(entity).get();\n";
-          file << "  renderer.set_position(physics.x, physics.y);\n";
-        }
-      }
       file << "}\n";
       file << "\n";
     }
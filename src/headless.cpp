@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include <raylib.h>
+
+#include "bullet.hpp"
+#include "game.hpp"
+#include "physics.hpp"
+#include "player.hpp"
+#include "profiler.hpp"
+#include "renderers.hpp"
+#include "room_cache.hpp"
+
+// Runs the game simulation without a window, audio device or GPU and reports the update throughput.
+// Usage: headless [--serial] [level] [ticks]
+//        headless --bullet-soak [bullets]
+// --serial runs all systems one after another on the main thread.
+
+[[nodiscard]] static double get_time()
+{
+  auto now = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(now.time_since_epoch()).count();
+}
+
+[[nodiscard]] static size_t resident_memory()
+{
+  size_t pages    = 0;
+  size_t resident = 0;
+  if (FILE *file = fopen("/proc/self/statm", "r"))
+  {
+    if (fscanf(file, "%zu %zu", &pages, &resident) != 2)
+      resident = 0;
+    fclose(file);
+  }
+
+  return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+template<typename C>
+[[nodiscard]] static size_t reference_count()
+{
+  return Manager::get().component_containers[C::id()].template get_manager<C>().reference_count();
+}
+
+// Spawns bullets next to the player in batches, runs a tick so they add their Physics and SpriteRenderer,
+// and destroys them again. Reference tables and resident memory have to stay flat however many bullets were spawned.
+static void bullet_soak(int bullet_count)
+{
+  constexpr int BATCH_SIZE   = 256;
+  constexpr int REPORT_EVERY = 100000;
+
+  auto players = get_components<Player>();
+  assert(!players.empty() && "No player to spawn bullets at");
+  const auto &player = get_component<Physics>(players.front().entity).get();
+
+  printf("reference slots per component type\n");
+  printf("%-10s %-10s %-10s %-16s %-12s %-12s\n",
+         "bullets",
+         "Bullet",
+         "Physics",
+         "SpriteRenderer",
+         "entities",
+         "resident MB");
+
+  std::vector<Entity> bullets;
+  bullets.reserve(BATCH_SIZE);
+
+  const double start = get_time();
+  for (int spawned = 0; spawned < bullet_count;)
+  {
+    for (int i = 0; i < BATCH_SIZE && spawned < bullet_count; i++, spawned++)
+    {
+      const float vx = (i % 2 == 0) ? 2.0f : -2.0f;
+      bullets.push_back(add_entity(Bullet(INVALID_ENTITY, player.x, player.y - 8, vx, 0.0f)));
+    }
+
+    G_update_game();
+
+    // Bullets that hit something destroyed themselves already
+    for (const auto bullet : bullets)
+    {
+      if (entity_exists(bullet))
+        destroy_entity(bullet);
+    }
+    Manager::get().call_destroy();
+    bullets.clear();
+
+    if (spawned % REPORT_EVERY < BATCH_SIZE || spawned == bullet_count)
+    {
+      printf("%-10d %-10zu %-10zu %-16zu %-12zu %-12.2f\n",
+             spawned,
+             reference_count<Bullet>(),
+             reference_count<Physics>(),
+             reference_count<SpriteRenderer>(),
+             entity_count(),
+             resident_memory() / (1024.0 * 1024.0));
+    }
+  }
+  const double elapsed = get_time() - start;
+
+  printf("bullets: %d, time: %.3f s, us/bullet: %.2f\n", bullet_count, elapsed, elapsed * 1e6 / bullet_count);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1 && std::string_view(argv[1]) == "--serial")
+  {
+    Manager::get().serial_systems = true;
+    argc -= 1;
+    argv += 1;
+  }
+
+  if (argc > 1 && std::string_view(argv[1]) == "--bullet-soak")
+  {
+    SetTraceLogLevel(LOG_WARNING);
+    G_create_game();
+    bullet_soak(argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000000);
+    return 0;
+  }
+
+  const char *level = argc > 1 ? argv[1] : nullptr;
+  const int ticks   = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3600;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  G_create_game();
+  if (level)
+    G_load_level(level);
+
+  Profiler::get().reset();
+
+  const double start = get_time();
+  for (int i = 0; i < ticks; i++)
+    G_update_game();
+  const double elapsed = get_time() - start;
+
+  printf("level: %s, systems: %s\n", level ? level : "(start)", Manager::get().serial_systems ? "serial" : "parallel");
+  printf("ticks: %d, time: %.3f s, ticks/s: %.1f, us/tick: %.2f\n",
+         ticks,
+         elapsed,
+         ticks / elapsed,
+         elapsed * 1e6 / ticks);
+  Profiler::get().print(stdout, ticks);
+  Level::RoomCache::get().print_stats(stdout);
+
+  return 0;
+}
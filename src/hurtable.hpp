@@ -7,6 +7,9 @@ struct Hurtable
 {
   COMPONENT(Hurtable);
 
+  // Only touches itself
+  using writes = ComponentTypes<>;
+
   void update()
   {
     invincibility_frames = std::max(0, invincibility_frames - 1);
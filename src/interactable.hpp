@@ -22,7 +22,7 @@ struct Interactable
   struct ActionLevelStore
   {
     std::string entity_level_id;
-    std::string key;
+    Level::FieldId key{ Level::INVALID_FIELD };
     Level::Field field;
   };
 
@@ -1,9 +1,20 @@
 #include "level.hpp"
 
+#include <chrono>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <vector>
+
 #include "block.hpp"
 #include "level_loader.hpp"
+#include "level_streamer.hpp"
 #include "player.hpp"
+#include "profiler.hpp"
 #include "renderers.hpp"
+#include "room_cache.hpp"
+#include "tile_collision.hpp"
+#include "world_streamer.hpp"
 
 #include "magic_enum.hpp"
 
@@ -23,26 +34,106 @@ Level::~Level()
 
 void Level::load(const std::string &name)
 {
-  destroy_non_persistent_entities();
-  auto &manager = Manager::get();
-  manager.call_destroy();
+  PROFILE_SCOPE("level load");
+
+  auto &load_profiler = LoadProfiler::get();
+  load_profiler.begin(name);
+
+  const auto start    = std::chrono::steady_clock::now();
+  const auto settings = get_load_settings();
+  auto &manager       = Manager::get();
+
+  // Streamed worlds keep the rooms around the player resident, and a reload constructs the room again
+  const bool use_room_cache = cache_rooms && !settings.stream_world && (!level_loader || level_loader->name != name);
+  if (use_room_cache && level_loader)
+  {
+    const LoadTimer timer{ LoadProfiler::Store };
+    auto room            = std::make_unique<RoomCache::Room>();
+    room->settings       = loaded_settings;
+    room->level_loader   = std::move(*level_loader);
+    room->tile_collision = std::move(TileCollision::get());
+    room->snapshot       = manager.take_non_persistent_entities();
+    RoomCache::get().store(std::move(room));
+  }
+
+  auto cached = use_room_cache ? RoomCache::get().take(name, settings) : nullptr;
+
+  std::unique_ptr<PreparedLevel> prepared;
+  const char *source = "cached";
+  if (!cached)
+  {
+    prepared = settings.stream_world ? WorldStreamer::get().take(name, settings)
+                                     : LevelStreamer::get().take(name, settings);
+    source   = prepared ? "prefetched" : "loaded now";
+    if (!prepared)
+    {
+      // Levels prepared on the streaming thread do not add to the time of the load
+      prepared = prepare(name, settings);
+      load_profiler.add(LoadProfiler::Parse, prepared->parse_time);
+      load_profiler.add(LoadProfiler::Prepare, prepared->prepare_time);
+    }
+  }
+
+  {
+    const LoadTimer timer{ LoadProfiler::Destroy };
+    if (!settings.stream_world)
+      WorldStreamer::get().clear();
 
+    destroy_non_persistent_entities();
+    manager.call_destroy();
+  }
+
+  auto &new_level_loader = cached ? cached->level_loader : prepared->level_loader;
   if (!level_loader)
-    level_loader = new LevelLoader(name);
+    level_loader = new LevelLoader(std::move(new_level_loader));
   else
-    level_loader->load(name);
+    *level_loader = std::move(new_level_loader);
 
-  for (const auto &tile : level_loader->tiles)
+  if (cached)
   {
-    const auto &tileset = level_loader->tilesets[tile.tileset_id];
+    const LoadTimer timer{ LoadProfiler::Restore };
+    TileCollision::get() = std::move(cached->tile_collision);
+    manager.restore_entities(std::move(cached->snapshot));
+  }
+  else
+  {
+    create_tile_collision(*prepared);
+    create_entities(*level_loader, *prepared);
+  }
 
-    if (tileset.enum_tiles.contains("Solid") && tileset.enum_tiles.at("Solid").contains(tile.id))
-      add_entity(Block(tile));
+  {
+    const LoadTimer timer{ LoadProfiler::Init };
+    manager.call_init();
   }
+  loaded_settings = settings;
 
-  create_entities(*level_loader);
+  const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  printf("Entered level %s in %.2f ms (%s)\n", name.c_str(), elapsed, source);
+  load_profiler.end(source);
+  if (cache_rooms)
+    RoomCache::get().print_stats(stdout);
 
-  manager.call_init();
+  // Resident rooms request their own neighbours, cached rooms do not need to be prepared
+  if (prefetch_neighbours && !settings.stream_world)
+  {
+    std::vector<LevelName> neighbours;
+    for (const auto &[_, neighbour] : level_loader->neighbours)
+    {
+      if (cache_rooms && RoomCache::get().contains(neighbour, settings))
+        continue;
+
+      if (std::find(neighbours.begin(), neighbours.end(), neighbour) == neighbours.end())
+        neighbours.push_back(neighbour);
+    }
+
+    LevelStreamer::get().prefetch(neighbours, settings);
+  }
+}
+
+LoadSettings Level::get_load_settings() const
+{
+  const bool bake = bake_tile_chunks && IsWindowReady();
+  return LoadSettings{ use_tile_collision, bake, stream_world && bake };
 }
 
 void Level::reload()
@@ -51,36 +142,315 @@ void Level::reload()
     load(level_loader->name);
 }
 
-void Level::create_entities(const LevelLoader &level_loader)
+[[nodiscard]] static uint8_t get_tile_collision_flags(const LevelLoader &level_loader, const Tile &tile)
+{
+  const auto tileset_it = level_loader.tilesets.find(tile.tileset_id);
+  if (tileset_it == level_loader.tilesets.end())
+    return TileCollision::None;
+
+  static const TileTags SOLID_TAG   = tile_tag("Solid");
+  static const TileTags ONE_WAY_TAG = tile_tag("OneWay");
+
+  const auto tags = tileset_it->second.get_tags(tile.id);
+
+  uint8_t flags = TileCollision::None;
+  if (tags & SOLID_TAG)
+    flags |= TileCollision::Solid;
+  if (tags & ONE_WAY_TAG)
+    flags |= TileCollision::Solid | TileCollision::OneWay;
+
+  return flags;
+}
+
+static void prepare_tile_collision(PreparedLevel &prepared)
 {
-  const auto &tiles = level_loader.tiles;
+  const auto &level_loader = prepared.level_loader;
 
-  auto tile_entity = create_entity();
-  for (const auto &tile : tiles)
+  // Without the collision map, solid tiles of each layer are merged into as few Block bodies as possible
+  for (const auto &tile : level_loader.tiles)
   {
-    const auto &tileset_id = tile.tileset_id;
+    const auto flags = get_tile_collision_flags(level_loader, tile);
+    if (flags == TileCollision::None)
+      continue;
+
+    prepared.solid_tiles += 1;
+
+    auto &cells = prepared.collision_layers[prepared.settings.use_tile_collision ? 0 : tile.depth];
+    if (cells.empty())
+      cells.reset(level_loader.width, level_loader.height, tile.size.w);
+
+    cells.set(tile.position.x, tile.position.y, tile.size.w, tile.size.h, flags);
+  }
+}
+
+void Level::create_tile_collision(PreparedLevel &prepared)
+{
+  const LoadTimer timer{ LoadProfiler::Collision };
 
-    auto position = tile.position;
-    position.x += tile.size.w / 2;
-    position.y += tile.size.h / 2;
-    const auto &tileset = level_loader.tilesets.at(tileset_id);
-    auto &tile_renderer =
-      add_component(tile_entity, TileRenderer{ tileset.path, position, tile.size, tile.source_position }).get();
-    tile_renderer.depth = tile.depth;
+  auto &tile_collision = TileCollision::get();
+  tile_collision.clear();
+
+  size_t blocks = 0;
+  if (prepared.settings.use_tile_collision)
+  {
+    if (!prepared.collision_layers.empty())
+      tile_collision = std::move(prepared.collision_layers.begin()->second);
   }
+  else
+  {
+    for (const auto &[_, layer] : prepared.collision_layers)
+    {
+      layer.for_each_rectangle(
+        [&blocks](int x, int y, int w, int h, uint8_t flags)
+        {
+          add_entity(Block(x, y, w, h, flags & TileCollision::OneWay));
+          blocks += 1;
+        });
+    }
+  }
+
+  if (!tile_collision.empty())
+  {
+    // Collision callbacks expect a solid Physics body on the other entity
+    tile_collision.entity = create_entity();
+    auto &physics         = add_component(tile_collision.entity, Physics()).get();
+    physics.solid         = true;
+    physics.movable       = false;
+    physics.collidable    = false;
+    physics.do_update     = false;
+  }
+
+  if (prepared.settings.use_tile_collision)
+    printf("Solid tiles: %zu (collision map)\n", prepared.solid_tiles);
+  else
+    printf("Solid tiles: %zu, merged into %zu blocks\n", prepared.solid_tiles, blocks);
+}
+
+[[nodiscard]] static std::string get_normal_map_path(const std::string &path)
+{
+  const auto extension = path.rfind('.');
+  if (extension == std::string::npos)
+    return path + "_normal";
+
+  return path.substr(0, extension) + "_normal" + path.substr(extension);
+}
+
+void Level::add_tile_renderer(const LevelLoader &level_loader, ::Entity tile_entity, const Tile &tile, TilePosition offset)
+{
+  auto position = tile.position;
+  position.x += tile.size.w / 2 + offset.x;
+  position.y += tile.size.h / 2 + offset.y;
+  const auto &tileset = level_loader.tilesets.at(tile.tileset_id);
+  auto &tile_renderer =
+    add_component(tile_entity, TileRenderer{ tileset.path, position, tile.size, tile.source_position }).get();
+  tile_renderer.depth = tile.depth;
+}
+
+static void prepare_tile_chunks(PreparedLevel &prepared)
+{
+  const auto &level_loader = prepared.level_loader;
+
+  struct ChunkKey
+  {
+    TilesetId tileset_id;
+    int depth;
+    int chunk_x;
+    int chunk_y;
+
+    auto operator<=>(const ChunkKey &) const = default;
+  };
 
-  // create entities ids
-  auto &entity_registry = LevelRegistry::get().entity_registry;
-  std::map<std::string, ::Entity> entity_ids;
+  const auto chunk_of = [](int position)
+  {
+    return position >= 0 ? position / Level::TILE_CHUNK_SIZE
+                         : (position - Level::TILE_CHUNK_SIZE + 1) / Level::TILE_CHUNK_SIZE;
+  };
+
+  // Tiles keep their level order inside a chunk, so overlapping layers with the same depth stay in order
+  std::map<ChunkKey, std::vector<const Tile *>> chunks;
+
+  for (size_t i = 0; i < level_loader.tiles.size(); i++)
+  {
+    const auto &tile    = level_loader.tiles[i];
+    const auto &tileset = level_loader.tilesets.at(tile.tileset_id);
+    if (!FileExists(get_normal_map_path(tileset.path).c_str()))
+    {
+      prepared.unbaked_tiles.push_back(i);
+      continue;
+    }
+
+    chunks[{ tile.tileset_id, tile.depth, chunk_of(tile.position.x), chunk_of(tile.position.y) }].push_back(&tile);
+  }
+
+  struct TilesetImages
+  {
+    Image base;
+    Image normal;
+  };
+  std::map<TilesetId, TilesetImages> tileset_images;
+
+  for (const auto &[key, chunk_tiles] : chunks)
+  {
+    int left   = std::numeric_limits<int>::max();
+    int top    = std::numeric_limits<int>::max();
+    int right  = std::numeric_limits<int>::min();
+    int bottom = std::numeric_limits<int>::min();
+    for (const auto *tile : chunk_tiles)
+    {
+      left   = std::min(left, tile->position.x);
+      top    = std::min(top, tile->position.y);
+      right  = std::max(right, tile->position.x + tile->size.w);
+      bottom = std::max(bottom, tile->position.y + tile->size.h);
+    }
+
+    const auto &tileset    = level_loader.tilesets.at(key.tileset_id);
+    const auto normal_path = get_normal_map_path(tileset.path);
+
+    auto images_it = tileset_images.find(key.tileset_id);
+    if (images_it == tileset_images.end())
+    {
+      TilesetImages images{ LoadImage(tileset.path.c_str()), LoadImage(normal_path.c_str()) };
+      ImageFormat(&images.base, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+      ImageFormat(&images.normal, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+      images_it = tileset_images.emplace(key.tileset_id, images).first;
+    }
+    const auto &images = images_it->second;
+
+    // Pixels are copied instead of blended: the normal map has partial alpha, and the shader discards
+    // transparent base pixels, so the topmost opaque tile pixel has to win in both textures
+    const int width  = right - left;
+    const int height = bottom - top;
+    Image base       = GenImageColor(width, height, BLANK);
+    Image normal     = GenImageColor(width, height, BLANK);
+
+    const auto *base_source   = static_cast<const Color *>(images.base.data);
+    const auto *normal_source = static_cast<const Color *>(images.normal.data);
+    auto *base_pixels         = static_cast<Color *>(base.data);
+    auto *normal_pixels       = static_cast<Color *>(normal.data);
+
+    for (const auto *tile : chunk_tiles)
+    {
+      for (int ty = 0; ty < tile->size.h; ty++)
+      {
+        const int source_y = tile->source_position.source_y + ty;
+        if (source_y < 0 || source_y >= images.base.height || source_y >= images.normal.height)
+          continue;
+
+        for (int tx = 0; tx < tile->size.w; tx++)
+        {
+          const int source_x = tile->source_position.source_x + tx;
+          if (source_x < 0 || source_x >= images.base.width || source_x >= images.normal.width)
+            continue;
+
+          const auto &pixel = base_source[source_y * images.base.width + source_x];
+          if (pixel.a == 0)
+            continue;
+
+          const size_t index   = (tile->position.y - top + ty) * width + (tile->position.x - left + tx);
+          base_pixels[index]   = pixel;
+          normal_pixels[index] = normal_source[source_y * images.normal.width + source_x];
+        }
+      }
+    }
+
+    prepared.tile_chunks.push_back(PreparedTileChunk{ normal_path, { left, top }, key.depth, base, normal });
+  }
+
+  for (auto &[_, images] : tileset_images)
+  {
+    UnloadImage(images.base);
+    UnloadImage(images.normal);
+  }
+}
+
+void Level::upload_tile_chunk(PreparedTileChunk &chunk, ::Entity tile_entity, TilePosition offset)
+{
+  const auto texture        = LoadTextureFromImage(chunk.base);
+  const auto normal_texture = LoadTextureFromImage(chunk.normal);
+  UnloadImage(chunk.base);
+  UnloadImage(chunk.normal);
+  chunk.base   = Image{};
+  chunk.normal = Image{};
+
+  const TilePosition position{ chunk.position.x + offset.x, chunk.position.y + offset.y };
+  add_component(tile_entity, TileChunkRenderer{ chunk.normal_path, position, chunk.depth, texture, normal_texture });
+}
+
+void Level::create_tile_chunks(const LevelLoader &level_loader, PreparedLevel &prepared, ::Entity tile_entity)
+{
+  for (auto &chunk : prepared.tile_chunks)
+    upload_tile_chunk(chunk, tile_entity);
+
+  printf("Tiles: %zu, baked into %zu chunks (%zu drawn separately)\n",
+         level_loader.tiles.size(),
+         prepared.tile_chunks.size(),
+         prepared.unbaked_tiles.size());
+}
+
+std::unique_ptr<PreparedLevel> Level::prepare(const LevelName &name, const LoadSettings &settings)
+{
+  const auto parse_start = std::chrono::steady_clock::now();
+  auto prepared          = std::make_unique<PreparedLevel>();
+  prepared->settings     = settings;
+  prepared->level_loader.load(name);
+
+  const auto prepare_start = std::chrono::steady_clock::now();
+  prepared->parse_time     = std::chrono::duration<double>(prepare_start - parse_start).count();
+
+  prepare_tile_collision(*prepared);
+
+  if (settings.bake_tile_chunks)
+    prepare_tile_chunks(*prepared);
+  else
+  {
+    prepared->unbaked_tiles.resize(prepared->level_loader.tiles.size());
+    std::iota(prepared->unbaked_tiles.begin(), prepared->unbaked_tiles.end(), 0);
+  }
+
+  prepared->prepare_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - prepare_start).count();
+  return prepared;
+}
+
+void Level::create_entities(const LevelLoader &level_loader, PreparedLevel &prepared)
+{
+  auto &load_profiler  = LoadProfiler::get();
+  auto phase_start     = std::chrono::steady_clock::now();
+  const auto end_phase = [&](LoadProfiler::Phase phase)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    load_profiler.add(phase, std::chrono::duration<double>(now - phase_start).count());
+    phase_start = now;
+  };
+
+  if (prepared.settings.stream_world)
+  {
+    WorldStreamer::get().enter(level_loader, prepared);
+  }
+  else
+  {
+    auto tile_entity = create_entity();
+    if (prepared.settings.bake_tile_chunks)
+      create_tile_chunks(level_loader, prepared, tile_entity);
+
+    for (const auto tile_index : prepared.unbaked_tiles)
+      add_tile_renderer(level_loader, tile_entity, level_loader.tiles[tile_index]);
+  }
+  end_phase(LoadProfiler::Tiles);
+
+  static const EntityTypeId PLAYER_POSITION_TYPE = entity_type("PlayerPosition");
+
+  // create entities ids, indexed like the level entities
+  const auto &entity_registry = LevelRegistry::get();
+  std::vector<::Entity> entity_ids(level_loader.entities.size(), INVALID_ENTITY);
   for (const auto &[id, level_entity] : level_loader.entities)
   {
-    if (entity_registry.contains(level_entity.name))
+    if (entity_registry.find(level_entity.type))
     {
-      entity_ids[id] = create_entity();
-      printf("Created entity %s (%lu)\n", id.c_str(), entity_ids[id]);
+      entity_ids[level_entity.index] = create_entity();
+      printf("Created entity %s (%lu)\n", id.c_str(), entity_ids[level_entity.index]);
     }
 
-    if (level_entity.name == "PlayerPosition")
+    if (level_entity.type == PLAYER_POSITION_TYPE)
     {
       if (reset_player_position)
       {
@@ -100,17 +470,20 @@ void Level::create_entities(const LevelLoader &level_loader)
     }
   }
 
+  end_phase(LoadProfiler::Entities);
+
   // resolve entity references
   for (auto &[id, level_entity] : level_loader.entities)
   {
-    for (auto &[field_name, field] : level_entity.fields)
+    for (auto &[_, field] : level_entity.fields)
     {
       if (std::holds_alternative<EntityRef>(field))
       {
         auto &entity_ref = std::get<EntityRef>(field);
-        if (entity_ids.contains(entity_ref.level_entity_id))
+        if (entity_ref.level_entity_index < entity_ids.size() &&
+            entity_ids[entity_ref.level_entity_index] != INVALID_ENTITY)
         {
-          entity_ref.game_entity_id = entity_ids.at(entity_ref.level_entity_id);
+          entity_ref.game_entity_id = entity_ids[entity_ref.level_entity_index];
           printf("Resolved entity reference %s (%lu)\n", entity_ref.level_entity_id.c_str(), entity_ref.game_entity_id);
         }
         else
@@ -121,14 +494,15 @@ void Level::create_entities(const LevelLoader &level_loader)
     }
   }
 
+  end_phase(LoadProfiler::References);
+
   // invoke entity component constructors
   for (const auto &[id, level_entity] : level_loader.entities)
   {
-    if (entity_registry.contains(level_entity.name))
-    {
-      entity_registry[level_entity.name](level_entity, entity_ids.at(id));
-    }
+    if (const auto construct = entity_registry.find(level_entity.type))
+      construct(level_entity, entity_ids[level_entity.index]);
   }
+  end_phase(LoadProfiler::Construct);
 }
 
 int64_t Level::get_world_x() const
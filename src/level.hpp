@@ -1,8 +1,10 @@
 #pragma once
 
-#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "level_definitions.hpp"
 #include "manager.hpp"
@@ -12,53 +14,106 @@ struct LevelLoader;
 
 namespace Level
 {
-using EntityDef = Entity;
+using EntityDef         = Entity;
+using EntityConstructor = void (*)(const EntityDef &, ::Entity);
 
 struct LevelRegistry
 {
-  void register_entity(std::string name, const std::function<void(const EntityDef &, ::Entity)> &callback)
+  void register_entity(std::string_view name, EntityConstructor constructor)
   {
-    entity_registry[name] = callback;
+    const auto type = entity_type(name);
+    if (constructors.size() <= type)
+      constructors.resize(type + 1, nullptr);
+    constructors[type] = constructor;
   }
 
-  std::unordered_map<std::string, std::function<void(const EntityDef &, ::Entity)>> entity_registry;
+  // nullptr for entity types without components, like the player position
+  [[nodiscard]] inline EntityConstructor find(EntityTypeId type) const
+  {
+    return type < constructors.size() ? constructors[type] : nullptr;
+  }
+
+  // Indexed by entity type
+  std::vector<EntityConstructor> constructors;
 
   static LevelRegistry &get();
 };
 
+struct PreparedLevel;
+struct PreparedTileChunk;
+
+// Options that change how a level is prepared, prepared levels are only used with the same settings
+struct LoadSettings
+{
+  bool use_tile_collision{ true };
+  bool bake_tile_chunks{ true };
+  bool stream_world{ false };
+
+  bool operator==(const LoadSettings &) const = default;
+};
+
 struct Level
 {
   ~Level();
   void reload();
   void load(const std::string &name);
-  void create_entities(const LevelLoader &);
+  void create_entities(const LevelLoader &, PreparedLevel &);
+  void create_tile_collision(PreparedLevel &);
+  void create_tile_chunks(const LevelLoader &, PreparedLevel &, ::Entity);
   void load_neighbour(Direction);
 
+  static void add_tile_renderer(const LevelLoader &, ::Entity, const Tile &, TilePosition offset = {});
+  static void upload_tile_chunk(PreparedTileChunk &, ::Entity, TilePosition offset = {});
+
+  // Loads the level data and does all work that is safe outside of the main thread
+  [[nodiscard]] static std::unique_ptr<PreparedLevel> prepare(const LevelName &name, const LoadSettings &settings);
+  [[nodiscard]] LoadSettings get_load_settings() const;
+
   [[nodiscard]] int64_t get_world_x() const;
   [[nodiscard]] int64_t get_world_y() const;
   [[nodiscard]] int64_t get_width() const;
   [[nodiscard]] int64_t get_height() const;
   [[nodiscard]] std::string get_name() const;
 
-  static inline std::unordered_map<LevelEntityId, std::unordered_map<std::string, Field>> entity_fields;
-  static void store(const LevelEntityId &entity_id, const std::string &name, const Field &field)
+  // Fields that outlive the level, like killed enemies and collected batteries
+  static inline std::unordered_map<LevelEntityId, FieldMap> entity_fields;
+  static void store(const LevelEntityId &entity_id, FieldId id, const Field &field)
   {
-    printf("Storing field %s for entity %s\n", name.c_str(), entity_id.c_str());
-    entity_fields[entity_id][name] = field;
+    printf("Storing field %s for entity %s\n", field_name(id).c_str(), entity_id.c_str());
+    entity_fields[entity_id].set(id, field);
   }
 
-  static void load(const LevelEntityId &entity_id, const std::string &name, Field &field)
+  static void load(const LevelEntityId &entity_id, FieldId id, Field &field)
   {
-    if (!entity_fields.contains(entity_id) || !entity_fields[entity_id].contains(name))
+    const auto fields_it = entity_fields.find(entity_id);
+    if (fields_it == entity_fields.end())
       return;
 
-    field = entity_fields[entity_id][name];
+    if (const auto *stored = fields_it->second.find(id))
+      field = *stored;
   }
 
   bool reset_player_position{ true };
 
+  // Static solid tiles go into the TileCollision map instead of separate Block entities
+  bool use_tile_collision{ true };
+
+  // Static tile layers are baked into chunk textures instead of one TileRenderer per tile
+  bool bake_tile_chunks{ true };
+  static constexpr int TILE_CHUNK_SIZE = 256;
+
+  // Neighbours of the current level are prepared on the level streaming thread
+  bool prefetch_neighbours{ true };
+
+  // Keeps the tiles of neighbouring rooms resident and shows them next to the current room
+  bool stream_world{ false };
+
+  // Left rooms keep their entities in the RoomCache and are restored as they were left
+  bool cache_rooms{ true };
+
 private:
   LevelLoader *level_loader{ nullptr };
+  LoadSettings loaded_settings;
 };
 
 } // namespace Level
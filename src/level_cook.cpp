@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+#include "level_loader.hpp"
+#include "level_pack.hpp"
+
+// Cooks assets/level.ldtk into assets/level.bin and compares the load times of both formats.
+// Run from the directory that contains the assets.
+
+[[nodiscard]] static double get_time()
+{
+  auto now = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(now.time_since_epoch()).count();
+}
+
+static constexpr const char *LEVEL_PACK_PATH = "assets/level.bin";
+
+struct LoadTimes
+{
+  double project{ 0.0 };
+  double levels{ 0.0 };
+  double slowest_level{ 0.0 };
+  size_t level_count{ 0 };
+};
+
+[[nodiscard]] static LoadTimes measure_load_times(bool use_level_pack)
+{
+  LoadTimes times;
+
+  LevelLoader::unload_project();
+  LevelLoader::use_level_pack = use_level_pack;
+
+  double start = get_time();
+  LevelLoader::load_project();
+  times.project = get_time() - start;
+
+  for (const auto &name : LevelLoader::get_level_names())
+  {
+    start = get_time();
+    LevelLoader level_loader(name);
+    const double elapsed = get_time() - start;
+
+    times.levels += elapsed;
+    times.slowest_level = std::max(times.slowest_level, elapsed);
+    times.level_count += 1;
+  }
+
+  return times;
+}
+
+int main()
+{
+  LevelLoader::use_level_pack = false;
+  LevelLoader::load_project();
+  if (!LevelLoader::is_project_loaded())
+  {
+    fprintf(stderr, "Failed to load the level project\n");
+    return 1;
+  }
+
+  LevelPack::Writer writer;
+  size_t level_count = 0;
+  for (const auto &name : LevelLoader::get_level_names())
+  {
+    LevelLoader level_loader(name);
+    if (level_count == 0)
+      writer.add_tilesets(level_loader.tilesets);
+
+    writer.add_level(level_loader);
+    level_count += 1;
+  }
+
+  if (!writer.write(LEVEL_PACK_PATH))
+    return 1;
+
+  printf("Cooked %zu levels into %s\n", level_count, LEVEL_PACK_PATH);
+
+  const LoadTimes json = measure_load_times(false);
+  const LoadTimes pack = measure_load_times(true);
+
+  printf("%-8s %-12s %-16s %-16s %-16s\n", "format", "levels", "startup ms", "avg level ms", "max level ms");
+  for (const auto &[format, times] : { std::pair{ "json", json }, std::pair{ "pack", pack } })
+  {
+    printf("%-8s %-12zu %-16.3f %-16.3f %-16.3f\n",
+           format,
+           times.level_count,
+           times.project * 1e3,
+           times.level_count > 0 ? times.levels * 1e3 / times.level_count : 0.0,
+           times.slowest_level * 1e3);
+  }
+
+  return 0;
+}
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -41,20 +46,63 @@ using TilesetId = int64_t;
 using TileId    = int64_t;
 using TileIds   = std::set<TileId>;
 
-using Field    = std::variant<Tile, Color, std::string, int, float, bool, EntityRef>;
-using FieldMap = std::unordered_map<std::string, Field>;
+using Field = std::variant<Tile, Color, std::string, int, float, bool, EntityRef>;
+
+// Field names are interned to small ids when levels are loaded. Call sites that read the same field of many
+// entities keep the id in a static, so entity construction does not hash any strings.
+using FieldId                          = uint32_t;
+constexpr inline FieldId INVALID_FIELD = std::numeric_limits<FieldId>::max();
+
+[[nodiscard]] FieldId field_id(std::string_view name);
+// INVALID_FIELD when no level or call site used the name yet
+[[nodiscard]] FieldId find_field_id(std::string_view name);
+[[nodiscard]] const std::string &field_name(FieldId id);
+
+// Enum tags of tileset tiles are interned to bits of a mask. Call sites keep the bit of a tag in a static,
+// so checking the tags of a tile is an array index.
+using TileTags = uint64_t;
+
+[[nodiscard]] TileTags tile_tag(std::string_view name);
+
+// Level entity names are interned to compact type ids when levels are loaded. The level registry keeps the
+// constructor of every type in a table indexed by type id.
+using EntityTypeId                                = uint32_t;
+constexpr inline EntityTypeId INVALID_ENTITY_TYPE = std::numeric_limits<EntityTypeId>::max();
+
+[[nodiscard]] EntityTypeId entity_type(std::string_view name);
+
+// Position of an entity in the entity list of its level
+using LevelEntityIndex                                 = uint32_t;
+constexpr inline LevelEntityIndex INVALID_LEVEL_ENTITY = std::numeric_limits<LevelEntityIndex>::max();
 
 struct Tileset
 {
   TilesetId id;
   std::string path;
   std::map<std::string, TileIds> enum_tiles;
+
+  // Tags of every tile indexed by tile id, built from enum_tiles
+  std::vector<TileTags> tile_tags;
+
+  void build_tile_tags();
+
+  [[nodiscard]] inline TileTags get_tags(TileId tile_id) const
+  {
+    if (tile_id < 0 || static_cast<size_t>(tile_id) >= tile_tags.size())
+      return 0;
+    return tile_tags[static_cast<size_t>(tile_id)];
+  }
+
+  [[nodiscard]] inline bool has_tag(TileId tile_id, TileTags tag) const
+  {
+    return (get_tags(tile_id) & tag) != 0;
+  }
 };
 
 struct Tile
 {
-  TilesetId tileset_id;
-  TileId id;
+  TilesetId tileset_id{ 0 };
+  TileId id{ 0 };
   TilePosition position;
   TileSourcePosition source_position;
   TileSize size;
@@ -62,22 +110,12 @@ struct Tile
   int depth{ 0 };
 };
 
-struct Entity
-{
-  LevelEntityId id;
-  std::string name;
-  TilePosition position;
-  TileSize size;
-
-  std::optional<Tile> tile;
-
-  FieldMap fields;
-};
-
 struct EntityRef
 {
   ::Entity game_entity_id{ INVALID_ENTITY };
   ::LevelEntityId level_entity_id{ "" };
+  // Resolved when the level is loaded, INVALID_LEVEL_ENTITY when the entity is in another level
+  LevelEntityIndex level_entity_index{ INVALID_LEVEL_ENTITY };
 
   EntityRef() = default;
 
@@ -87,6 +125,97 @@ struct EntityRef
   }
 };
 
+// Fields of a level or entity in a flat array sorted by field id
+struct FieldMap
+{
+  using Entry = std::pair<FieldId, Field>;
+
+  [[nodiscard]] inline const Field *find(FieldId id) const
+  {
+    const auto entry_it = lower_bound(id);
+    return entry_it != entries.end() && entry_it->first == id ? &entry_it->second : nullptr;
+  }
+
+  [[nodiscard]] inline Field *find(FieldId id)
+  {
+    return const_cast<Field *>(std::as_const(*this).find(id));
+  }
+
+  [[nodiscard]] inline bool contains(FieldId id) const
+  {
+    return find(id) != nullptr;
+  }
+
+  inline void set(FieldId id, Field value)
+  {
+    const auto entry_it = lower_bound(id);
+    if (entry_it != entries.end() && entry_it->first == id)
+      entries[entry_it - entries.begin()].second = std::move(value);
+    else
+      entries.emplace(entry_it, id, std::move(value));
+  }
+
+  inline void reserve(size_t count)
+  {
+    entries.reserve(count);
+  }
+
+  [[nodiscard]] inline size_t size() const
+  {
+    return entries.size();
+  }
+
+  [[nodiscard]] inline bool empty() const
+  {
+    return entries.empty();
+  }
+
+  [[nodiscard]] inline auto begin() const
+  {
+    return entries.begin();
+  }
+
+  [[nodiscard]] inline auto end() const
+  {
+    return entries.end();
+  }
+
+  [[nodiscard]] inline auto begin()
+  {
+    return entries.begin();
+  }
+
+  [[nodiscard]] inline auto end()
+  {
+    return entries.end();
+  }
+
+private:
+  [[nodiscard]] inline std::vector<Entry>::const_iterator lower_bound(FieldId id) const
+  {
+    return std::lower_bound(entries.begin(),
+                            entries.end(),
+                            id,
+                            [](const Entry &entry, FieldId entry_id) { return entry.first < entry_id; });
+  }
+
+  std::vector<Entry> entries;
+};
+
+struct Entity
+{
+  LevelEntityId id;
+  std::string name;
+  EntityTypeId type{ INVALID_ENTITY_TYPE };
+  LevelEntityIndex index{ INVALID_LEVEL_ENTITY };
+  TilePosition position;
+  TileSize size;
+
+  std::optional<Tile> tile;
+
+  FieldMap fields;
+};
+
 using LevelName = std::string;
 enum Direction
 {
@@ -105,26 +234,25 @@ using EntityMap    = std::unordered_map<LevelEntityId, Level::Entity>;
 using NeighbourMap = std::unordered_map<Direction, LevelName>;
 
 template<typename T>
-[[nodiscard]] std::optional<T> get_field(const FieldMap &fields, const std::string &name)
+[[nodiscard]] std::optional<T> get_field(const FieldMap &fields, FieldId id)
 {
   if constexpr (std::is_same_v<T, ::Entity>)
   {
-    if (auto field = get_field<EntityRef>(fields, name))
+    if (auto field = get_field<EntityRef>(fields, id))
     {
-      fprintf(stderr, "Field '%s' is not an entity reference\n", name.c_str());
+      fprintf(stderr, "Field '%s' is not an entity reference\n", field_name(id).c_str());
       assert(field->game_entity_id > INVALID_ENTITY && "Invalid field entity id");
       return field->game_entity_id;
     }
   }
   else
   {
-    if (fields.contains(name))
+    if (const auto *field = fields.find(id))
     {
-      auto &field = fields.at(name);
-      if (auto value = std::get_if<T>(&field))
+      if (auto value = std::get_if<T>(field))
         return *value;
 
-      fprintf(stderr, "Field type mismatch for field '%s'\n", name.c_str());
+      fprintf(stderr, "Field type mismatch for field '%s'\n", field_name(id).c_str());
       assert(false && "Field type mismatch");
     }
   }
@@ -132,21 +260,21 @@ template<typename T>
 }
 
 template<typename T>
-inline void read_field(const FieldMap &fields, const std::string &name, T &value)
+inline void read_field(const FieldMap &fields, FieldId id, T &value)
 {
-  if (auto field = get_field<T>(fields, name))
+  if (auto field = get_field<T>(fields, id))
     value = *field;
   else
   {
-    fprintf(stderr, "Field '%s' not found\n", name.c_str());
+    fprintf(stderr, "Field '%s' not found\n", field_name(id).c_str());
     assert(false && "Field not found");
   }
 }
 
 template<typename T>
-inline void try_read_field(const FieldMap &fields, const std::string &name, T &value)
+inline void try_read_field(const FieldMap &fields, FieldId id, T &value)
 {
-  if (auto field = get_field<T>(fields, name))
+  if (auto field = get_field<T>(fields, id))
     value = *field;
 }
 
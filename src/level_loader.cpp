@@ -1,12 +1,21 @@
 #include "level_loader.hpp"
 
+#include <cassert>
+#include <chrono>
 #include <csignal>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 
 #include "ldtk.hpp"
+#include "level_pack.hpp"
 
 #if defined(DEBUG)
   #define ASSERT_RET(x, msg) \
@@ -45,25 +54,321 @@
   return get_assets_path() / file_name;
 }
 
+[[nodiscard]] static std::filesystem::path get_level_pack_path()
+{
+  const std::string file_name = "level.bin";
+  return get_assets_path() / file_name;
+}
+
 [[nodiscard]] static std::filesystem::path get_tileset_path(const std::string &file_name)
 {
   return get_assets_path() / file_name;
 }
 
+// Byte range of one level object in the project file, the level is parsed the first time it is entered
+struct LevelIndex
+{
+  std::string identifier;
+  std::string iid;
+  size_t begin{ 0 };
+  size_t end{ 0 };
+  std::unique_ptr<ldtk::Level> level;
+};
+
 struct Cache
 {
-  ldtk::Ldtk ldtk_project;
+  std::string project_json;
+  std::vector<LevelIndex> levels;
+  std::unordered_map<std::string, size_t> level_indices;
+  std::unordered_map<std::string, std::string> level_identifiers;
+  LevelPack::Pack level_pack;
   std::unordered_map<Level::TilesetId, Level::Tileset> tilesets;
 };
 
 static std::unique_ptr<Cache> cache;
+static std::recursive_mutex cache_mutex;
 static ldtk::Level null_level{};
 
-[[nodiscard]] static Level::TilesetMap load_tilesets()
+// Levels are loaded on the streaming thread while entities read fields on the main thread
+struct InternedNames
+{
+  struct Hash
+  {
+    using is_transparent = void;
+
+    [[nodiscard]] size_t operator()(std::string_view name) const
+    {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+
+  [[nodiscard]] uint32_t intern(std::string_view name)
+  {
+    {
+      std::shared_lock lock(mutex);
+      if (const auto id_it = ids.find(name); id_it != ids.end())
+        return id_it->second;
+    }
+
+    std::unique_lock lock(mutex);
+    const auto [id_it, inserted] = ids.try_emplace(std::string(name), static_cast<uint32_t>(names.size()));
+    if (inserted)
+      names.emplace_back(name);
+    return id_it->second;
+  }
+
+  [[nodiscard]] std::optional<uint32_t> find(std::string_view name)
+  {
+    std::shared_lock lock(mutex);
+    const auto id_it = ids.find(name);
+    return id_it != ids.end() ? std::optional(id_it->second) : std::nullopt;
+  }
+
+  [[nodiscard]] const std::string &name(uint32_t id)
+  {
+    std::shared_lock lock(mutex);
+    assert(id < names.size() && "Unknown interned name");
+    return names[id];
+  }
+
+  std::shared_mutex mutex;
+  std::unordered_map<std::string, uint32_t, Hash, std::equal_to<>> ids;
+  std::deque<std::string> names;
+};
+
+[[nodiscard]] static InternedNames &field_names()
+{
+  static InternedNames instance;
+  return instance;
+}
+
+[[nodiscard]] static InternedNames &tag_names()
+{
+  static InternedNames instance;
+  return instance;
+}
+
+[[nodiscard]] static InternedNames &entity_type_names()
+{
+  static InternedNames instance;
+  return instance;
+}
+
+namespace Level
+{
+FieldId field_id(std::string_view name)
+{
+  return field_names().intern(name);
+}
+
+FieldId find_field_id(std::string_view name)
+{
+  return field_names().find(name).value_or(INVALID_FIELD);
+}
+
+const std::string &field_name(FieldId id)
+{
+  return field_names().name(id);
+}
+
+TileTags tile_tag(std::string_view name)
+{
+  const auto bit = tag_names().intern(name);
+  assert(bit < std::numeric_limits<TileTags>::digits && "Too many tile tags");
+  return TileTags{ 1 } << bit;
+}
+
+EntityTypeId entity_type(std::string_view name)
+{
+  return entity_type_names().intern(name);
+}
+
+void Tileset::build_tile_tags()
+{
+  tile_tags.clear();
+
+  for (const auto &[name, tile_ids] : enum_tiles)
+  {
+    if (tile_ids.empty())
+      continue;
+
+    const auto tag = tile_tag(name);
+    const auto max = *tile_ids.rbegin();
+    if (tile_tags.size() <= static_cast<size_t>(max))
+      tile_tags.resize(static_cast<size_t>(max) + 1, 0);
+
+    for (const auto tile_id : tile_ids)
+    {
+      if (tile_id >= 0)
+        tile_tags[static_cast<size_t>(tile_id)] |= tag;
+    }
+  }
+}
+} // namespace Level
+
+// Finds value boundaries in the project text without building JSON values
+struct JsonScanner
+{
+  std::string_view text;
+  size_t position{ 0 };
+
+  void skip_whitespace()
+  {
+    while (position < text.size() &&
+           (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r'))
+      position++;
+  }
+
+  [[nodiscard]] bool consume(char c)
+  {
+    skip_whitespace();
+    if (position >= text.size() || text[position] != c)
+      return false;
+
+    position++;
+    return true;
+  }
+
+  // Escape sequences are kept as they are, identifiers and iids never contain them
+  [[nodiscard]] bool read_string(std::string_view &value)
+  {
+    if (!consume('"'))
+      return false;
+
+    const size_t begin = position;
+    while (position < text.size())
+    {
+      if (text[position] == '\\')
+        position += 2;
+      else if (text[position] == '"')
+      {
+        value = text.substr(begin, position - begin);
+        position++;
+        return true;
+      }
+      else
+        position++;
+    }
+
+    return false;
+  }
+
+  [[nodiscard]] bool skip_value()
+  {
+    skip_whitespace();
+    if (position >= text.size())
+      return false;
+
+    std::string_view value;
+    if (text[position] == '"')
+      return read_string(value);
+
+    if (text[position] == '{' || text[position] == '[')
+    {
+      int depth = 0;
+      while (position < text.size())
+      {
+        const char c = text[position];
+        if (c == '"')
+        {
+          if (!read_string(value))
+            return false;
+          continue;
+        }
+
+        if (c == '{' || c == '[')
+          depth++;
+        else if ((c == '}' || c == ']') && --depth == 0)
+        {
+          position++;
+          return true;
+        }
+
+        position++;
+      }
+
+      return false;
+    }
+
+    while (position < text.size() && text[position] != ',' && text[position] != '}' && text[position] != ']' &&
+           text[position] != ' ' && text[position] != '\t' && text[position] != '\n' && text[position] != '\r')
+      position++;
+
+    return true;
+  }
+
+  // Calls the callback for every key with the scanner placed at its value, which the callback has to consume
+  template<typename Callback>
+  [[nodiscard]] bool for_each_key(Callback &&callback)
+  {
+    if (!consume('{'))
+      return false;
+
+    if (consume('}'))
+      return true;
+
+    do
+    {
+      std::string_view key;
+      if (!read_string(key) || !consume(':'))
+        return false;
+
+      skip_whitespace();
+      if (!callback(key))
+        return false;
+    } while (consume(','));
+
+    return consume('}');
+  }
+};
+
+[[nodiscard]] static bool index_levels(JsonScanner &scanner)
+{
+  if (!scanner.consume('['))
+    return false;
+
+  if (scanner.consume(']'))
+    return true;
+
+  do
+  {
+    scanner.skip_whitespace();
+
+    LevelIndex index;
+    index.begin = scanner.position;
+
+    const bool scanned = scanner.for_each_key(
+      [&](std::string_view key)
+      {
+        std::string_view value;
+        if (key == "identifier" && scanner.read_string(value))
+          index.identifier = value;
+        else if (key == "iid" && scanner.read_string(value))
+          index.iid = value;
+        else
+          return scanner.skip_value();
+
+        return true;
+      });
+
+    if (!scanned || index.identifier.empty())
+      return false;
+
+    index.end = scanner.position;
+
+    cache->level_indices[index.identifier] = cache->levels.size();
+    cache->level_identifiers[index.iid]    = index.identifier;
+    cache->levels.push_back(std::move(index));
+  } while (scanner.consume(','));
+
+  return scanner.consume(']');
+}
+
+[[nodiscard]] static Level::TilesetMap load_tilesets(const ldtk::Definitions &defs)
 {
   Level::TilesetMap tilesets;
 
-  for (const auto &tileset_def : cache->ldtk_project.defs.tilesets)
+  for (const auto &tileset_def : defs.tilesets)
   {
     if (!tileset_def.rel_path.has_value())
       continue;
@@ -82,20 +387,87 @@ static ldtk::Level null_level{};
                      [](const auto &tile_id) { return tile_id; });
     }
 
+    tileset.build_tile_tags();
+    tilesets[tileset.id] = tileset;
+  }
+
+  return tilesets;
+}
+
+[[nodiscard]] static double get_elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+[[nodiscard]] static Level::TilesetMap load_pack_tilesets()
+{
+  Level::TilesetMap tilesets;
+
+  const auto &pack = cache->level_pack;
+  for (const auto &tileset_def : pack.tilesets())
+  {
+    Level::Tileset tileset;
+    tileset.id   = tileset_def.id;
+    tileset.path = pack.string(tileset_def.path);
+
+    for (const auto &enum_tag : pack.enum_tags(tileset_def.enum_tags))
+    {
+      const auto tile_ids = pack.tile_ids(enum_tag.tile_ids);
+      tileset.enum_tiles[std::string(pack.string(enum_tag.name))].insert(tile_ids.begin(), tile_ids.end());
+    }
+
+    tileset.build_tile_tags();
     tilesets[tileset.id] = tileset;
   }
 
   return tilesets;
 }
 
+// The pack is skipped when the LDtk project was saved after it was cooked
+[[nodiscard]] static bool is_level_pack_current()
+{
+  const std::filesystem::path pack_path    = get_level_pack_path();
+  const std::filesystem::path project_path = get_level_project_path();
+
+  std::error_code error;
+  if (!std::filesystem::exists(pack_path, error))
+    return false;
+
+  if (std::filesystem::exists(project_path, error) &&
+      std::filesystem::last_write_time(project_path, error) > std::filesystem::last_write_time(pack_path, error))
+  {
+    printf("Level pack %s is older than %s\n", pack_path.c_str(), project_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
 void LevelLoader::load_project()
 {
-  const std::filesystem::path path = get_level_project_path();
-  ASSERT_RET(std::filesystem::exists(path), "Level file not found");
+  std::lock_guard lock(cache_mutex);
+
+  const auto start = std::chrono::steady_clock::now();
 
   unload_project();
 
-  std::ifstream file(path);
+  if (use_level_pack && is_level_pack_current())
+  {
+    cache = std::make_unique<Cache>();
+    if (cache->level_pack.open(get_level_pack_path()) && !cache->level_pack.levels().empty())
+    {
+      cache->tilesets = load_pack_tilesets();
+      printf("Level project loaded from %s in %.2f ms\n", get_level_pack_path().c_str(), get_elapsed_ms(start));
+      return;
+    }
+
+    cache.reset();
+  }
+
+  const std::filesystem::path path = get_level_project_path();
+  ASSERT_RET(std::filesystem::exists(path), "Level file not found");
+
+  std::ifstream file(path, std::ios::binary);
   ASSERT_RET(file.is_open(), "Failed to open level file");
 
   if (!std::filesystem::exists(path) || !file.is_open())
@@ -104,35 +476,91 @@ void LevelLoader::load_project()
     return;
   }
 
-  nlohmann::json json = nlohmann::json::parse(file);
   cache               = std::make_unique<Cache>();
-  cache->ldtk_project = json.get<ldtk::Ldtk>();
-
+  cache->project_json = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
   file.close();
-  ASSERT_RET(!cache->ldtk_project.levels.empty(), "No levels found");
 
-  cache->tilesets = load_tilesets();
+  // Only the definitions are parsed up front, levels are indexed by their byte range in the file
+  JsonScanner scanner{ cache->project_json };
+  size_t defs_begin = 0;
+  size_t defs_end   = 0;
+
+  const bool indexed = scanner.for_each_key(
+    [&](std::string_view key)
+    {
+      if (key == "levels")
+        return index_levels(scanner);
+
+      if (key == "defs")
+        defs_begin = scanner.position;
+
+      const bool skipped = scanner.skip_value();
+      if (key == "defs")
+        defs_end = scanner.position;
+
+      return skipped;
+    });
+
+  if (!indexed || defs_end <= defs_begin)
+  {
+    fprintf(stderr, "Failed to index level file\n");
+    cache.reset();
+    ASSERT_RET(false, "Invalid level file");
+  }
+
+  ASSERT_RET(!cache->levels.empty(), "No levels found");
+
+  const auto defs = nlohmann::json::parse(cache->project_json.begin() + defs_begin,
+                                          cache->project_json.begin() + defs_end)
+                      .get<ldtk::Definitions>();
+
+  cache->tilesets = load_tilesets(defs);
+  printf("Level project loaded from %s in %.2f ms\n", path.c_str(), get_elapsed_ms(start));
 }
 
 void LevelLoader::unload_project()
 {
+  std::lock_guard lock(cache_mutex);
   cache.reset();
 }
 
 [[nodiscard]] bool LevelLoader::is_project_loaded()
 {
-  return cache != nullptr && !cache->ldtk_project.levels.empty();
+  std::lock_guard lock(cache_mutex);
+  return cache != nullptr && (cache->level_pack.is_open() || !cache->levels.empty());
 }
 
-[[nodiscard]] static inline std::string get_level_identifier(const std::string &iid)
+std::vector<Level::LevelName> LevelLoader::get_level_names()
 {
-  ASSERT_RET_VAL(LevelLoader::is_project_loaded(), "Project not loaded", "");
+  std::lock_guard lock(cache_mutex);
+
+  if (!is_project_loaded())
+    load_project();
+
+  std::vector<Level::LevelName> names;
+  ASSERT_RET_VAL(is_project_loaded(), "Project not loaded", names);
 
-  for (const auto &level : cache->ldtk_project.levels)
+  if (cache->level_pack.is_open())
   {
-    if (level.iid == iid)
-      return level.identifier;
+    for (const auto &level : cache->level_pack.levels())
+      names.emplace_back(cache->level_pack.string(level.identifier));
   }
+  else
+  {
+    for (const auto &level : cache->levels)
+      names.push_back(level.identifier);
+  }
+
+  return names;
+}
+
+[[nodiscard]] static inline std::string get_level_identifier(const std::string &iid)
+{
+  ASSERT_RET_VAL(LevelLoader::is_project_loaded(), "Project not loaded", "");
+
+  const auto identifier_it = cache->level_identifiers.find(iid);
+  if (identifier_it != cache->level_identifiers.end())
+    return identifier_it->second;
 
   ASSERT_RET_VAL(false, "Level identifier not found", "");
   return {};
@@ -142,19 +570,22 @@ void LevelLoader::unload_project()
 {
   ASSERT_RET_VAL(cache, "Project not loaded", null_level);
 
-  auto level_it = std::find_if(cache->ldtk_project.levels.begin(),
-                               cache->ldtk_project.levels.end(),
-                               [&name](const ldtk::Level &level) { return level.identifier == name; });
-
-  if (level_it == cache->ldtk_project.levels.end())
+  const auto index_it = cache->level_indices.find(name);
+  if (index_it == cache->level_indices.end())
   {
     fprintf(stderr, "Level not found %s\n", name.c_str());
     return null_level;
   }
 
-  ASSERT_RET_VAL(level_it != cache->ldtk_project.levels.end(), "Level not found", null_level);
+  auto &index = cache->levels[index_it->second];
+  if (!index.level)
+  {
+    const auto begin = cache->project_json.begin();
+    index.level      = std::make_unique<ldtk::Level>(
+      nlohmann::json::parse(begin + index.begin, begin + index.end).get<ldtk::Level>());
+  }
 
-  return *level_it;
+  return *index.level;
 }
 
 [[nodiscard]] static inline Level::Direction direction_from_string(const std::string &dir)
@@ -271,6 +702,7 @@ void LevelLoader::unload_project()
 [[nodiscard]] static Level::FieldMap load_fields(const std::vector<ldtk::FieldInstance> &field_instances)
 {
   Level::FieldMap fields;
+  fields.reserve(field_instances.size());
 
   for (const auto &ins : field_instances)
   {
@@ -280,41 +712,42 @@ void LevelLoader::unload_project()
       continue;
     }
 
+    const auto id = Level::field_id(ins.identifier);
     if (ins.type == "Tile")
     {
       ASSERT_RET_VAL(ins.value.is_object(), "Tile field value is not an object", {});
 
       Level::Tile t          = load_tile(ins.value.get<ldtk::TilesetRectangle>());
-      fields[ins.identifier] = t;
+      fields.set(id, t);
     }
     else if (ins.type == "String" || ins.type.starts_with("LocalEnum."))
     {
       ASSERT_RET_VAL(ins.value.is_string(), "String field value is not a string", {});
-      fields[ins.identifier] = ins.value.get<std::string>();
+      fields.set(id, ins.value.get<std::string>());
     }
     else if (ins.type == "Color")
     {
       ASSERT_RET_VAL(ins.value.is_string(), "Color field value is not a string", {});
-      fields[ins.identifier] = color_from_hex(ins.value.get<std::string>());
+      fields.set(id, color_from_hex(ins.value.get<std::string>()));
     }
     else if (ins.type == "Int")
     {
       ASSERT_RET_VAL(ins.value.is_number_integer(), "Int field value is not an integer", {});
-      fields[ins.identifier] = ins.value.get<int>();
+      fields.set(id, ins.value.get<int>());
     }
     else if (ins.type == "Bool")
     {
       ASSERT_RET_VAL(ins.value.is_boolean(), "Bool field value is not a boolean", {});
-      fields[ins.identifier] = ins.value.get<bool>();
+      fields.set(id, ins.value.get<bool>());
     }
     else if (ins.type == "Float")
     {
       if (!ins.value.is_number_float() && ins.value.is_number())
-        fields[ins.identifier] = static_cast<float>(ins.value.get<int>());
+        fields.set(id, static_cast<float>(ins.value.get<int>()));
       else
       {
         ASSERT_RET_VAL(ins.value.is_number_float(), "Float field value is not a float", {});
-        fields[ins.identifier] = ins.value.get<float>();
+        fields.set(id, ins.value.get<float>());
       }
     }
     else if (ins.type == "EntityRef")
@@ -326,7 +759,7 @@ void LevelLoader::unload_project()
       ldtk::ReferenceToAnEntityInstance ref = ins.value.get<ldtk::ReferenceToAnEntityInstance>();
       printf("EntityRef field %s\n", ref.entity_iid.c_str());
 
-      fields[ins.identifier] = Level::EntityRef(ref.entity_iid);
+      fields.set(id, Level::EntityRef(ref.entity_iid));
     }
     else
     {
@@ -353,6 +786,7 @@ void LevelLoader::unload_project()
     Level::Entity e;
     e.id         = ins.iid;
     e.name       = ins.identifier;
+    e.type       = Level::entity_type(e.name);
     e.position.x = ins.px[0] - pivot_x * ins.width;
     e.position.y = ins.px[1] - pivot_y * ins.height;
     e.size.w     = ins.width;
@@ -364,8 +798,9 @@ void LevelLoader::unload_project()
       e.tile->position = e.position;
     }
 
-    e.fields               = load_fields(ins.field_instances);
-    e.fields["Identifier"] = e.id;
+    static const auto IDENTIFIER_FIELD = Level::field_id("Identifier");
+    e.fields                           = load_fields(ins.field_instances);
+    e.fields.set(IDENTIFIER_FIELD, e.id);
 
     entities[e.id] = e;
   }
@@ -378,13 +813,137 @@ LevelLoader::LevelLoader(const std::string &name)
   load(name);
 }
 
+[[nodiscard]] static Level::Tile load_pack_tile(const LevelPack::Tile &tile)
+{
+  Level::Tile t;
+  t.tileset_id               = tile.tileset_id;
+  t.id                       = tile.id;
+  t.position.x               = tile.x;
+  t.position.y               = tile.y;
+  t.source_position.source_x = tile.source_x;
+  t.source_position.source_y = tile.source_y;
+  t.size.w                   = tile.w;
+  t.size.h                   = tile.h;
+  t.depth                    = tile.depth;
+
+  return t;
+}
+
+[[nodiscard]] static Level::FieldMap load_pack_fields(const LevelPack::Pack &pack, const LevelPack::Range &range)
+{
+  Level::FieldMap fields;
+  fields.reserve(range.count);
+
+  for (const auto &field : pack.fields(range))
+  {
+    const auto id = Level::field_id(pack.string(field.name));
+
+    switch (field.type)
+    {
+      case LevelPack::TileField:
+        fields.set(id, load_pack_tile(field.tile));
+        break;
+      case LevelPack::ColorField:
+        fields.set(id, Color{ field.color[0], field.color[1], field.color[2], field.color[3] });
+        break;
+      case LevelPack::StringField:
+        fields.set(id, std::string(pack.string(field.string)));
+        break;
+      case LevelPack::IntField:
+        fields.set(id, static_cast<int>(field.int_value));
+        break;
+      case LevelPack::FloatField:
+        fields.set(id, field.float_value);
+        break;
+      case LevelPack::BoolField:
+        fields.set(id, field.bool_value != 0);
+        break;
+      case LevelPack::EntityRefField:
+        fields.set(id, Level::EntityRef(std::string(pack.string(field.string))));
+        break;
+      default:
+        fprintf(stderr, "Field %s, pack type %u unsupported\n", Level::field_name(id).c_str(), field.type);
+        ASSERT_RET_VAL(false, "Unsupported field type", fields);
+    }
+  }
+
+  return fields;
+}
+
 void LevelLoader::load(const std::string &name)
 {
+  std::lock_guard lock(cache_mutex);
+
   if (!is_project_loaded())
     load_project();
 
   ASSERT_RET(is_project_loaded(), "Project not loaded");
 
+  const auto start     = std::chrono::steady_clock::now();
+  const bool from_pack = cache->level_pack.is_open();
+  if (from_pack)
+    load_from_pack(name);
+  else
+    load_from_json(name);
+
+  printf("Level %s loaded from %s in %.3f ms\n", name.c_str(), from_pack ? "pack" : "json", get_elapsed_ms(start));
+}
+
+void LevelLoader::load_from_pack(const std::string &name)
+{
+  const auto &pack  = cache->level_pack;
+  const auto *level = pack.find_level(name);
+  if (!level)
+    fprintf(stderr, "Level not found %s\n", name.c_str());
+  ASSERT_RET(level, "Level not found");
+
+  this->iid  = pack.string(level->iid);
+  this->name = pack.string(level->identifier);
+  printf("Loading level %s (%s)\n", this->name.c_str(), this->iid.c_str());
+  this->world_x = level->world_x;
+  this->world_y = level->world_y;
+  this->width   = level->width;
+  this->height  = level->height;
+  this->fields  = load_pack_fields(pack, level->fields);
+
+  this->neighbours.clear();
+  for (size_t direction = 0; direction < LevelPack::DIRECTION_COUNT; direction++)
+  {
+    if (level->neighbours[direction].size > 0)
+      this->neighbours[static_cast<Level::Direction>(direction)] = pack.string(level->neighbours[direction]);
+  }
+
+  this->tilesets = cache->tilesets;
+
+  const auto level_tiles = pack.tiles(level->tiles);
+  this->tiles.clear();
+  this->tiles.reserve(level_tiles.size());
+  for (const auto &tile : level_tiles)
+    this->tiles.push_back(load_pack_tile(tile));
+
+  this->entities.clear();
+  for (const auto &entity : pack.entities(level->entities))
+  {
+    Level::Entity e;
+    e.id         = pack.string(entity.iid);
+    e.name       = pack.string(entity.name);
+    e.type       = Level::entity_type(e.name);
+    e.position.x = entity.x;
+    e.position.y = entity.y;
+    e.size.w     = entity.w;
+    e.size.h     = entity.h;
+    if (entity.has_tile)
+      e.tile = load_pack_tile(entity.tile);
+    e.fields = load_pack_fields(pack, entity.fields);
+
+    this->entities[e.id] = e;
+  }
+
+  index_entities();
+}
+
+void LevelLoader::load_from_json(const std::string &name)
+{
   const ldtk::Level &level = get_level(name);
   this->iid                = level.iid;
   this->name               = level.identifier;
@@ -424,4 +983,31 @@ void LevelLoader::load(const std::string &name)
       this->entities.insert(std::begin(layer_entities), std::end(layer_entities));
     }
   }
+
+  index_entities();
+}
+
+void LevelLoader::index_entities()
+{
+  std::unordered_map<std::string_view, Level::LevelEntityIndex> indices;
+  indices.reserve(this->entities.size());
+
+  Level::LevelEntityIndex index = 0;
+  for (auto &[id, entity] : this->entities)
+  {
+    entity.index = index++;
+    indices[id]  = entity.index;
+  }
+
+  for (auto &[id, entity] : this->entities)
+  {
+    for (auto &[_, field] : entity.fields)
+    {
+      if (auto *entity_ref = std::get_if<Level::EntityRef>(&field))
+      {
+        const auto index_it            = indices.find(entity_ref->level_entity_id);
+        entity_ref->level_entity_index = index_it != indices.end() ? index_it->second : Level::INVALID_LEVEL_ENTITY;
+      }
+    }
+  }
 }
@@ -9,8 +9,10 @@
 
 #include "level_definitions.hpp"
 
+// Levels may be loaded from the level streaming thread, access to the shared project is serialized
 struct LevelLoader
 {
+  LevelLoader() = default;
   LevelLoader(const Level::LevelName &);
   void load(const Level::LevelName &);
 
@@ -29,8 +31,16 @@ struct LevelLoader
   Level::FieldMap fields;
 
   static bool is_project_loaded();
-
-private:
   static void load_project();
   static void unload_project();
+  [[nodiscard]] static std::vector<Level::LevelName> get_level_names();
+
+  // Levels are read from the cooked pack when it exists and is newer than the LDtk project
+  static inline bool use_level_pack{ true };
+
+private:
+  void load_from_pack(const Level::LevelName &);
+  void load_from_json(const Level::LevelName &);
+  // Numbers the entities and resolves entity references to those numbers
+  void index_entities();
 };
@@ -0,0 +1,422 @@
+#include "level_pack.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "level_loader.hpp"
+
+namespace LevelPack
+{
+static_assert(std::is_trivially_copyable_v<Level> && std::is_trivially_copyable_v<Entity> &&
+                std::is_trivially_copyable_v<Field> && std::is_trivially_copyable_v<Tileset>,
+              "Pack records are read in place");
+static_assert(std::is_same_v<std::variant_alternative_t<TileField, ::Level::Field>, ::Level::Tile> &&
+                std::is_same_v<std::variant_alternative_t<ColorField, ::Level::Field>, Color> &&
+                std::is_same_v<std::variant_alternative_t<StringField, ::Level::Field>, std::string> &&
+                std::is_same_v<std::variant_alternative_t<IntField, ::Level::Field>, int> &&
+                std::is_same_v<std::variant_alternative_t<FloatField, ::Level::Field>, float> &&
+                std::is_same_v<std::variant_alternative_t<BoolField, ::Level::Field>, bool> &&
+                std::is_same_v<std::variant_alternative_t<EntityRefField, ::Level::Field>, ::Level::EntityRef>,
+              "Field types do not match Level::Field");
+
+static constexpr size_t SECTION_ALIGNMENT = 8;
+
+[[nodiscard]] static constexpr size_t section_record_size(SectionId id)
+{
+  switch (id)
+  {
+    case Levels:
+      return sizeof(Level);
+    case Tilesets:
+      return sizeof(Tileset);
+    case EnumTags:
+      return sizeof(EnumTag);
+    case TileIds:
+      return sizeof(int32_t);
+    case Tiles:
+      return sizeof(Tile);
+    case Entities:
+      return sizeof(Entity);
+    case Fields:
+      return sizeof(Field);
+    case Strings:
+      return sizeof(char);
+    case SectionCount:
+      break;
+  }
+
+  return 0;
+}
+
+Pack::~Pack()
+{
+  close();
+}
+
+bool Pack::open(const std::string &path)
+{
+  close();
+
+#if defined(__linux__)
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(Header)))
+  {
+    ::close(fd);
+    return false;
+  }
+
+  size = static_cast<size_t>(file_stat.st_size);
+
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (mapping != MAP_FAILED)
+  {
+    data   = static_cast<const uint8_t *>(mapping);
+    mapped = true;
+  }
+#endif
+
+  // Other platforms and file systems that cannot be mapped read the pack into memory instead
+  if (!mapped)
+  {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+      return false;
+
+    const auto file_size = static_cast<std::streamoff>(file.tellg());
+    if (file_size < static_cast<std::streamoff>(sizeof(Header)))
+      return false;
+
+    size = static_cast<size_t>(file_size);
+    buffer.resize(size);
+    file.seekg(0);
+    if (file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(size)))
+      data = buffer.data();
+  }
+
+  if (!data || !validate())
+  {
+    fprintf(stderr, "Invalid level pack %s\n", path.c_str());
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void Pack::close()
+{
+#if defined(__linux__)
+  if (mapped && data)
+    munmap(const_cast<uint8_t *>(data), size);
+#endif
+
+  data   = nullptr;
+  size   = 0;
+  mapped = false;
+  buffer.clear();
+  buffer.shrink_to_fit();
+}
+
+bool Pack::validate() const
+{
+  const auto &header = *reinterpret_cast<const Header *>(data);
+  if (header.magic != MAGIC || header.version != VERSION || header.size != size)
+    return false;
+
+  for (uint32_t id = 0; id < SectionCount; id++)
+  {
+    const auto &section = header.sections[id];
+    if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > size)
+      return false;
+    if (section.count > (size - section.offset) / section_record_size(static_cast<SectionId>(id)))
+      return false;
+  }
+
+  return true;
+}
+
+template<typename T>
+std::span<const T> Pack::section(SectionId id) const
+{
+  assert(is_open() && "Level pack is not open");
+
+  const auto &section = reinterpret_cast<const Header *>(data)->sections[id];
+  return { reinterpret_cast<const T *>(data + section.offset), static_cast<size_t>(section.count) };
+}
+
+template<typename T>
+std::span<const T> Pack::section(SectionId id, const Range &range) const
+{
+  const auto records = section<T>(id);
+  if (range.first > records.size() || range.count > records.size() - range.first)
+  {
+    assert(false && "Level pack range out of bounds");
+    return {};
+  }
+
+  return records.subspan(range.first, range.count);
+}
+
+std::string_view Pack::string(const String &value) const
+{
+  const auto characters = section<char>(Strings, Range{ value.offset, value.size });
+  return { characters.data(), characters.size() };
+}
+
+const Level *Pack::find_level(std::string_view identifier) const
+{
+  for (const auto &level : levels())
+  {
+    if (string(level.identifier) == identifier)
+      return &level;
+  }
+
+  return nullptr;
+}
+
+std::span<const Level> Pack::levels() const
+{
+  return section<Level>(Levels);
+}
+
+std::span<const Tileset> Pack::tilesets() const
+{
+  return section<Tileset>(Tilesets);
+}
+
+std::span<const EnumTag> Pack::enum_tags(const Range &range) const
+{
+  return section<EnumTag>(EnumTags, range);
+}
+
+std::span<const int32_t> Pack::tile_ids(const Range &range) const
+{
+  return section<int32_t>(TileIds, range);
+}
+
+std::span<const Tile> Pack::tiles(const Range &range) const
+{
+  return section<Tile>(Tiles, range);
+}
+
+std::span<const Entity> Pack::entities(const Range &range) const
+{
+  return section<Entity>(Entities, range);
+}
+
+std::span<const Field> Pack::fields(const Range &range) const
+{
+  return section<Field>(Fields, range);
+}
+
+[[nodiscard]] static int32_t to_int32(int64_t value)
+{
+  assert(value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max() &&
+         "Value does not fit into the level pack");
+  return static_cast<int32_t>(value);
+}
+
+String Writer::add_string(std::string_view value)
+{
+  const String ret{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size()) };
+  strings.append(value);
+  return ret;
+}
+
+Tile Writer::make_tile(const ::Level::Tile &tile) const
+{
+  return Tile{ to_int32(tile.tileset_id),
+               to_int32(tile.id),
+               tile.position.x,
+               tile.position.y,
+               tile.source_position.source_x,
+               tile.source_position.source_y,
+               tile.size.w,
+               tile.size.h,
+               tile.depth };
+}
+
+Range Writer::add_fields(const ::Level::FieldMap &field_map)
+{
+  const Range range{ static_cast<uint32_t>(fields.size()), static_cast<uint32_t>(field_map.size()) };
+
+  for (const auto &[id, value] : field_map)
+  {
+    Field field;
+    std::memset(&field, 0, sizeof(field));
+    field.name = add_string(::Level::field_name(id));
+    field.type = static_cast<FieldType>(value.index());
+
+    switch (field.type)
+    {
+      case TileField:
+        field.tile = make_tile(std::get<::Level::Tile>(value));
+        break;
+      case ColorField:
+      {
+        const auto &color = std::get<Color>(value);
+        field.color[0]    = color.r;
+        field.color[1]    = color.g;
+        field.color[2]    = color.b;
+        field.color[3]    = color.a;
+        break;
+      }
+      case StringField:
+        field.string = add_string(std::get<std::string>(value));
+        break;
+      case IntField:
+        field.int_value = std::get<int>(value);
+        break;
+      case FloatField:
+        field.float_value = std::get<float>(value);
+        break;
+      case BoolField:
+        field.bool_value = std::get<bool>(value);
+        break;
+      case EntityRefField:
+        field.string = add_string(std::get<::Level::EntityRef>(value).level_entity_id);
+        break;
+    }
+
+    fields.push_back(field);
+  }
+
+  return range;
+}
+
+void Writer::add_tilesets(const ::Level::TilesetMap &tileset_map)
+{
+  for (const auto &[id, tileset] : tileset_map)
+  {
+    Tileset record;
+    record.id        = id;
+    record.path      = add_string(tileset.path);
+    record.enum_tags = Range{ static_cast<uint32_t>(enum_tags.size()), static_cast<uint32_t>(tileset.enum_tiles.size()) };
+
+    for (const auto &[name, ids] : tileset.enum_tiles)
+    {
+      enum_tags.push_back(
+        EnumTag{ add_string(name), Range{ static_cast<uint32_t>(tile_ids.size()), static_cast<uint32_t>(ids.size()) } });
+      for (const auto tile_id : ids)
+        tile_ids.push_back(to_int32(tile_id));
+    }
+
+    tilesets.push_back(record);
+  }
+}
+
+void Writer::add_level(const LevelLoader &level_loader)
+{
+  Level level;
+  std::memset(&level, 0, sizeof(level));
+  level.identifier = add_string(level_loader.name);
+  level.iid        = add_string(level_loader.iid);
+  level.world_x    = level_loader.world_x;
+  level.world_y    = level_loader.world_y;
+  level.width      = level_loader.width;
+  level.height     = level_loader.height;
+  level.fields     = add_fields(level_loader.fields);
+
+  for (const auto &[direction, name] : level_loader.neighbours)
+  {
+    assert(static_cast<size_t>(direction) < DIRECTION_COUNT && "Invalid neighbour direction");
+    level.neighbours[direction] = add_string(name);
+  }
+
+  level.tiles = Range{ static_cast<uint32_t>(tiles.size()), static_cast<uint32_t>(level_loader.tiles.size()) };
+  for (const auto &tile : level_loader.tiles)
+    tiles.push_back(make_tile(tile));
+
+  // Entity fields are appended while the entity records are built, so the records are added afterwards
+  std::vector<Entity> level_entities;
+  level_entities.reserve(level_loader.entities.size());
+  for (const auto &[id, entity] : level_loader.entities)
+  {
+    Entity record;
+    std::memset(&record, 0, sizeof(record));
+    record.iid      = add_string(entity.id);
+    record.name     = add_string(entity.name);
+    record.x        = entity.position.x;
+    record.y        = entity.position.y;
+    record.w        = entity.size.w;
+    record.h        = entity.size.h;
+    record.has_tile = entity.tile.has_value();
+    if (entity.tile.has_value())
+      record.tile = make_tile(entity.tile.value());
+    record.fields = add_fields(entity.fields);
+
+    level_entities.push_back(record);
+  }
+
+  level.entities = Range{ static_cast<uint32_t>(entities.size()), static_cast<uint32_t>(level_entities.size()) };
+  entities.insert(entities.end(), level_entities.begin(), level_entities.end());
+
+  levels.push_back(level);
+}
+
+bool Writer::write(const std::string &path) const
+{
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic   = MAGIC;
+  header.version = VERSION;
+
+  std::vector<uint8_t> output(sizeof(Header), 0);
+
+  const auto add_section = [&](SectionId id, const void *records, size_t count)
+  {
+    output.resize((output.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT, 0);
+
+    header.sections[id] = Section{ output.size(), count };
+
+    const auto *bytes = static_cast<const uint8_t *>(records);
+    output.insert(output.end(), bytes, bytes + count * section_record_size(id));
+  };
+
+  add_section(Levels, levels.data(), levels.size());
+  add_section(Tilesets, tilesets.data(), tilesets.size());
+  add_section(EnumTags, enum_tags.data(), enum_tags.size());
+  add_section(TileIds, tile_ids.data(), tile_ids.size());
+  add_section(Tiles, tiles.data(), tiles.size());
+  add_section(Entities, entities.data(), entities.size());
+  add_section(Fields, fields.data(), fields.size());
+  add_section(Strings, strings.data(), strings.size());
+
+  header.size = output.size();
+  std::memcpy(output.data(), &header, sizeof(header));
+
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file)
+  {
+    fprintf(stderr, "Failed to open %s for writing\n", path.c_str());
+    return false;
+  }
+
+  const bool written = fwrite(output.data(), 1, output.size(), file) == output.size();
+  fclose(file);
+
+  if (!written)
+    fprintf(stderr, "Failed to write %s\n", path.c_str());
+
+  return written;
+}
+
+} // namespace LevelPack
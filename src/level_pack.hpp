@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "level_definitions.hpp"
+
+struct LevelLoader;
+
+// Cooked level data written offline from the LDtk project by level_cook.
+// The file is memory mapped on Linux and read into memory elsewhere. Records are read in place: every record has a
+// fixed size, records of one kind are stored in one section and referenced by index ranges, and strings point into
+// a shared string table.
+namespace LevelPack
+{
+static constexpr uint32_t MAGIC   = 0x4b50564c; // "LVPK"
+static constexpr uint32_t VERSION = 1;
+
+struct String
+{
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct Range
+{
+  uint32_t first;
+  uint32_t count;
+};
+
+struct Tile
+{
+  int32_t tileset_id;
+  int32_t id;
+  int32_t x;
+  int32_t y;
+  int32_t source_x;
+  int32_t source_y;
+  int32_t w;
+  int32_t h;
+  int32_t depth;
+};
+
+// Same order as the alternatives of Level::Field
+enum FieldType : uint32_t
+{
+  TileField,
+  ColorField,
+  StringField,
+  IntField,
+  FloatField,
+  BoolField,
+  EntityRefField,
+};
+
+struct Field
+{
+  String name;
+  FieldType type;
+  union
+  {
+    Tile tile;
+    uint8_t color[4];
+    String string;
+    int32_t int_value;
+    float float_value;
+    uint32_t bool_value;
+  };
+};
+
+struct Entity
+{
+  String iid;
+  String name;
+  int32_t x;
+  int32_t y;
+  int32_t w;
+  int32_t h;
+  uint32_t has_tile;
+  Tile tile;
+  Range fields;
+};
+
+static constexpr size_t DIRECTION_COUNT = 8;
+
+struct Level
+{
+  String identifier;
+  String iid;
+  int64_t world_x;
+  int64_t world_y;
+  int64_t width;
+  int64_t height;
+  Range tiles;
+  Range entities;
+  Range fields;
+  // Neighbour identifiers indexed by Level::Direction, empty when there is no neighbour
+  String neighbours[DIRECTION_COUNT];
+};
+
+struct EnumTag
+{
+  String name;
+  Range tile_ids;
+};
+
+struct Tileset
+{
+  int64_t id;
+  String path;
+  Range enum_tags;
+};
+
+enum SectionId : uint32_t
+{
+  Levels,
+  Tilesets,
+  EnumTags,
+  TileIds,
+  Tiles,
+  Entities,
+  Fields,
+  Strings,
+  SectionCount
+};
+
+struct Section
+{
+  uint64_t offset;
+  uint64_t count;
+};
+
+struct Header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t size;
+  Section sections[SectionCount];
+};
+
+// Read-only view of a cooked level pack
+struct Pack
+{
+  Pack() = default;
+  ~Pack();
+
+  Pack(const Pack &)            = delete;
+  Pack &operator=(const Pack &) = delete;
+
+  [[nodiscard]] bool open(const std::string &path);
+  void close();
+
+  [[nodiscard]] inline bool is_open() const
+  {
+    return data != nullptr;
+  }
+
+  [[nodiscard]] const Level *find_level(std::string_view identifier) const;
+  [[nodiscard]] std::string_view string(const String &value) const;
+
+  [[nodiscard]] std::span<const Level> levels() const;
+  [[nodiscard]] std::span<const Tileset> tilesets() const;
+  [[nodiscard]] std::span<const EnumTag> enum_tags(const Range &range) const;
+  [[nodiscard]] std::span<const int32_t> tile_ids(const Range &range) const;
+  [[nodiscard]] std::span<const Tile> tiles(const Range &range) const;
+  [[nodiscard]] std::span<const Entity> entities(const Range &range) const;
+  [[nodiscard]] std::span<const Field> fields(const Range &range) const;
+
+private:
+  template<typename T>
+  [[nodiscard]] std::span<const T> section(SectionId id) const;
+
+  template<typename T>
+  [[nodiscard]] std::span<const T> section(SectionId id, const Range &range) const;
+
+  [[nodiscard]] bool validate() const;
+
+  const uint8_t *data{ nullptr };
+  size_t size{ 0 };
+  bool mapped{ false };
+  std::vector<uint8_t> buffer;
+};
+
+// Collects levels loaded from the JSON project and writes them as a pack
+struct Writer
+{
+  void add_tilesets(const ::Level::TilesetMap &tilesets);
+  void add_level(const LevelLoader &level_loader);
+
+  [[nodiscard]] bool write(const std::string &path) const;
+
+private:
+  [[nodiscard]] String add_string(std::string_view value);
+  [[nodiscard]] Tile make_tile(const ::Level::Tile &tile) const;
+  [[nodiscard]] Range add_fields(const ::Level::FieldMap &fields);
+
+  std::vector<Level> levels;
+  std::vector<Tileset> tilesets;
+  std::vector<EnumTag> enum_tags;
+  std::vector<int32_t> tile_ids;
+  std::vector<Tile> tiles;
+  std::vector<Entity> entities;
+  std::vector<Field> fields;
+  std::string strings;
+};
+
+} // namespace LevelPack
@@ -0,0 +1,161 @@
+#include "level_streamer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace Level
+{
+PreparedLevel::~PreparedLevel()
+{
+  for (auto &chunk : tile_chunks)
+  {
+    if (chunk.base.data)
+      UnloadImage(chunk.base);
+    if (chunk.normal.data)
+      UnloadImage(chunk.normal);
+  }
+}
+
+LevelStreamer &LevelStreamer::get()
+{
+  static LevelStreamer instance;
+  return instance;
+}
+
+LevelStreamer::~LevelStreamer()
+{
+  stop();
+}
+
+void LevelStreamer::prefetch(const std::vector<LevelName> &names, const LoadSettings &settings)
+{
+#if defined(EMSCRIPTEN)
+  // Web builds run without threads, levels are loaded when they are entered
+  return;
+#endif
+
+  std::lock_guard lock(mutex);
+
+  wanted          = names;
+  wanted_settings = settings;
+
+  std::erase_if(prepared,
+                [&](const auto &entry)
+                {
+                  return entry.second->settings != settings ||
+                         std::find(names.begin(), names.end(), entry.first) == names.end();
+                });
+
+  requests.clear();
+  for (const auto &name : names)
+  {
+    if (!prepared.contains(name) && name != in_progress)
+      requests.push_back(name);
+  }
+
+  if (!worker.joinable())
+  {
+    stopping = false;
+    worker   = std::thread(&LevelStreamer::run, this);
+  }
+
+  requested.notify_one();
+}
+
+std::unique_ptr<PreparedLevel> LevelStreamer::take(const LevelName &name, const LoadSettings &settings)
+{
+  std::unique_lock lock(mutex);
+
+  std::erase(requests, name);
+  finished.wait(lock, [&] { return in_progress != name; });
+
+  const auto prepared_it = prepared.find(name);
+  if (prepared_it == prepared.end())
+    return nullptr;
+
+  auto level = std::move(prepared_it->second);
+  prepared.erase(prepared_it);
+
+  if (level->settings != settings)
+    return nullptr;
+
+  return level;
+}
+
+std::unique_ptr<PreparedLevel> LevelStreamer::try_take(const LevelName &name, const LoadSettings &settings)
+{
+  std::lock_guard lock(mutex);
+
+  const auto prepared_it = prepared.find(name);
+  if (prepared_it == prepared.end())
+    return nullptr;
+
+  auto level = std::move(prepared_it->second);
+  prepared.erase(prepared_it);
+
+  if (level->settings != settings)
+    return nullptr;
+
+  return level;
+}
+
+void LevelStreamer::stop()
+{
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+    requests.clear();
+  }
+
+  requested.notify_all();
+  if (worker.joinable())
+    worker.join();
+
+  std::lock_guard lock(mutex);
+  prepared.clear();
+  wanted.clear();
+  stopping = false;
+}
+
+void LevelStreamer::run()
+{
+  std::unique_lock lock(mutex);
+
+  while (true)
+  {
+    requested.wait(lock, [&] { return stopping || !requests.empty(); });
+    if (stopping)
+      break;
+
+    const LevelName name        = requests.front();
+    const LoadSettings settings = wanted_settings;
+    requests.pop_front();
+    in_progress = name;
+
+    lock.unlock();
+    const auto start     = std::chrono::steady_clock::now();
+    auto level           = Level::prepare(name, settings);
+    const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Prepared level %s in %.2f ms\n", name.c_str(), elapsed);
+    lock.lock();
+
+    const bool still_wanted =
+      settings == wanted_settings && std::find(wanted.begin(), wanted.end(), name) != wanted.end();
+    if (still_wanted)
+      prepared[name] = std::move(level);
+
+    in_progress.clear();
+    finished.notify_all();
+
+    // A dropped level releases its images outside of the lock
+    if (level)
+    {
+      lock.unlock();
+      level.reset();
+      lock.lock();
+    }
+  }
+}
+
+} // namespace Level
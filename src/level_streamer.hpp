@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "level.hpp"
+#include "level_loader.hpp"
+#include "tile_collision.hpp"
+
+namespace Level
+{
+struct PreparedTileChunk
+{
+  std::string normal_path;
+  TilePosition position;
+  int depth{ 0 };
+  Image base{};
+  Image normal{};
+};
+
+// Everything a level transition needs that does not touch the ECS or the GPU
+struct PreparedLevel
+{
+  PreparedLevel() = default;
+  ~PreparedLevel();
+
+  PreparedLevel(const PreparedLevel &)            = delete;
+  PreparedLevel &operator=(const PreparedLevel &) = delete;
+
+  LoadSettings settings;
+  LevelLoader level_loader;
+
+  // Solid cells per layer depth, the collision map keeps all of them in a single layer
+  std::map<int, TileCollision> collision_layers;
+  size_t solid_tiles{ 0 };
+
+  // Chunk images are uploaded to textures on the main thread
+  std::vector<PreparedTileChunk> tile_chunks;
+  // Indices of the level tiles that get their own TileRenderer
+  std::vector<size_t> unbaked_tiles;
+
+  // Seconds spent in LevelLoader::load and in the rest of Level::prepare, on whichever thread prepared it
+  double parse_time{ 0.0 };
+  double prepare_time{ 0.0 };
+};
+
+// Prepares neighbouring levels on a worker thread while the current level is played
+struct LevelStreamer
+{
+  [[nodiscard]] static LevelStreamer &get();
+  ~LevelStreamer();
+
+  // Replaces pending requests, prepared levels that are not requested again are dropped
+  void prefetch(const std::vector<LevelName> &names, const LoadSettings &settings);
+
+  // Hands over a prepared level and waits for it when it is being prepared right now.
+  // Returns nullptr when the level was not requested or was prepared with different settings.
+  [[nodiscard]] std::unique_ptr<PreparedLevel> take(const LevelName &name, const LoadSettings &settings);
+
+  // Hands over a prepared level without waiting, nullptr while it is not ready
+  [[nodiscard]] std::unique_ptr<PreparedLevel> try_take(const LevelName &name, const LoadSettings &settings);
+
+  // Joins the worker and drops all prepared levels
+  void stop();
+
+private:
+  void run();
+
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable requested;
+  std::condition_variable finished;
+
+  std::deque<LevelName> requests;
+  std::vector<LevelName> wanted;
+  LoadSettings wanted_settings;
+  LevelName in_progress;
+  std::unordered_map<LevelName, std::unique_ptr<PreparedLevel>> prepared;
+  bool stopping{ false };
+};
+
+} // namespace Level
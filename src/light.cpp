@@ -7,13 +7,16 @@ REGISTER_COMPONENT(Light);
 COMPONENT_TEMPLATE(Light);
 REGISTER_LEVEL_ENTITY(Light);
 
+static const Level::FieldId SIZE_FIELD      = Level::field_id("Size");
+static const Level::FieldId INTENSITY_FIELD = Level::field_id("Intensity");
+
 Light::Light(const Level::Entity &entity)
 {
   start_x = entity.position.x + entity.size.w / 2;
   start_y = entity.position.y + entity.size.h / 2;
 
-  Level::read_field(entity.fields, "Size", size);
-  Level::read_field(entity.fields, "Intensity", intensity);
+  Level::read_field(entity.fields, SIZE_FIELD, size);
+  Level::read_field(entity.fields, INTENSITY_FIELD, intensity);
 }
 
 Light::Light(int x, int y)
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <raylib.h>
+
+#include "game.hpp"
+#include "level.hpp"
+#include "level_loader.hpp"
+#include "manager.hpp"
+#include "profiler.hpp"
+
+// Loads every level of the project in sequence, repeated a number of passes, and reports the time of each
+// load phase summed over a pass. Levels are neither prefetched nor cached, so every load does all the work.
+// Usage: load_benchmark [passes] [csv]
+
+int main(int argc, char **argv)
+{
+  const int passes     = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+  const char *csv_path = argc > 2 ? argv[2] : nullptr;
+
+  SetTraceLogLevel(LOG_WARNING);
+  G_create_game();
+
+  LevelLoader::load_project();
+  const auto names = LevelLoader::get_level_names();
+
+  auto &load_profiler         = LoadProfiler::get();
+  load_profiler.print_reports = false;
+
+  constexpr size_t TOTAL = LoadProfiler::PHASE_COUNT;
+  std::array<std::vector<double>, TOTAL + 1> pass_times;
+  {
+    // Entities are constructed for the created game, but the game level is left alone
+    Level::Level level;
+    level.prefetch_neighbours = false;
+    level.cache_rooms         = false;
+
+    // The first pass warms up the project cache and the allocator
+    for (const auto &name : names)
+      level.load(name);
+
+    if (csv_path && !load_profiler.open_csv(csv_path))
+      return 1;
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+      std::array<double, TOTAL + 1> times{};
+      for (const auto &name : names)
+      {
+        level.load(name);
+
+        const auto &report = load_profiler.get_report();
+        for (size_t phase = 0; phase < TOTAL; phase++)
+          times[phase] += report.phases[phase];
+        times[TOTAL] += report.total;
+      }
+
+      for (size_t phase = 0; phase <= TOTAL; phase++)
+        pass_times[phase].push_back(times[phase]);
+    }
+
+    destroy_non_persistent_entities();
+    Manager::get().call_destroy();
+  }
+
+  load_profiler.close_csv();
+
+  printf("levels: %zu, passes: %d, ms per pass\n", names.size(), passes);
+  printf("%-12s %-12s %-12s %-12s\n", "phase", "min", "median", "max");
+  for (size_t phase = 0; phase <= TOTAL; phase++)
+  {
+    auto &times = pass_times[phase];
+    std::sort(times.begin(), times.end());
+    printf("%-12s %-12.3f %-12.3f %-12.3f\n",
+           phase < TOTAL ? LoadProfiler::phase_name(static_cast<LoadProfiler::Phase>(phase)) : "total",
+           times.front() * 1e3,
+           times[times.size() / 2] * 1e3,
+           times.back() * 1e3);
+  }
+
+  return 0;
+}
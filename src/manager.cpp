@@ -1,6 +1,10 @@
 #include "manager.hpp"
 
+#include <chrono>
+#include <utility>
+
 #include "utils.hpp"
+#include "worker_pool.hpp"
 
 Manager *manager_instance{ nullptr };
 
@@ -33,6 +37,159 @@ void Manager::unregister_all()
     if (container.valid)
       container.uninitialize();
   }
+
+  // Function pointers in the system table point into the unloaded library
+  for (auto &phase_systems : systems)
+    phase_systems.clear();
+  for (auto &phase_systems : registered_systems)
+    phase_systems.clear();
+  collision_systems.clear();
+  destroyed_systems.clear();
+  remove_systems.clear();
+  systems_dirty = true;
+}
+
+// Registered systems share type 0, so ties between them keep the registration order
+template<typename Function>
+static void sort_systems(std::vector<Manager::System<Function>> &systems)
+{
+  std::stable_sort(systems.begin(),
+                   systems.end(),
+                   [](const auto &a, const auto &b)
+                   {
+                     if (a.priority != b.priority)
+                       return a.priority > b.priority;
+                     return a.type < b.type;
+                   });
+}
+
+void Manager::build_systems()
+{
+  for (auto &phase_systems : systems)
+    phase_systems.clear();
+  collision_systems.clear();
+  destroyed_systems.clear();
+  remove_systems.clear();
+
+  for (const auto &[id, container] : component_containers)
+  {
+    if (!container.valid)
+      continue;
+
+    for (size_t phase = 0; phase < PhaseCount; phase++)
+    {
+      if (container.systems[phase])
+        systems[phase].push_back(
+          { container.systems[phase], container.manager, id, container.priority, container.mask, container.access });
+    }
+
+    if (container.collision)
+      collision_systems.push_back({ container.collision, container.manager, id, container.priority, container.mask });
+
+    if (container.destroyed)
+      destroyed_systems.push_back({ container.destroyed, container.manager, id, container.priority, container.mask });
+
+    if (container.remove_entities)
+      remove_systems.push_back(
+        { container.remove_entities, container.manager, id, container.priority, container.mask });
+  }
+
+  for (size_t phase = 0; phase < PhaseCount; phase++)
+    systems[phase].insert(systems[phase].end(), registered_systems[phase].begin(), registered_systems[phase].end());
+
+  for (auto &phase_systems : systems)
+    sort_systems(phase_systems);
+  sort_systems(collision_systems);
+  sort_systems(destroyed_systems);
+  sort_systems(remove_systems);
+
+  // Systems that do not declare their access conflict with every other system
+  for (auto &phase_systems : systems)
+  {
+    for (auto &system : phase_systems)
+    {
+      system.reads  = 0;
+      system.writes = 0;
+      if (!system.access || !system.access(system.reads, system.writes))
+      {
+        system.reads  = std::numeric_limits<ComponentMask>::max();
+        system.writes = std::numeric_limits<ComponentMask>::max();
+      }
+    }
+  }
+
+  build_stages(Phase::Preupdate);
+  build_stages(Phase::Update);
+  build_stages(Phase::Postupdate);
+
+  systems_dirty = false;
+}
+
+[[nodiscard]] static bool systems_conflict(const Manager::System<Manager::SystemFunction> &a,
+                                           const Manager::System<Manager::SystemFunction> &b)
+{
+  return (a.writes & (b.reads | b.writes)) != 0 || (b.writes & a.reads) != 0;
+}
+
+void Manager::build_stages(Phase phase)
+{
+  const auto &phase_systems = systems[phase];
+
+  // A system goes into the stage after the last stage with a system it conflicts with. Conflicting systems keep
+  // their priority order, so the results are the same as running the systems one after another.
+  std::vector<uint32_t> stages(phase_systems.size(), 0);
+  uint32_t stage_count = 0;
+  for (size_t i = 0; i < phase_systems.size(); i++)
+  {
+    for (size_t j = 0; j < i; j++)
+    {
+      if (systems_conflict(phase_systems[i], phase_systems[j]))
+        stages[i] = std::max(stages[i], stages[j] + 1);
+    }
+    stage_count = std::max(stage_count, stages[i] + 1);
+  }
+
+  auto &order = stage_systems[phase];
+  auto &ends  = stage_ends[phase];
+  order.clear();
+  ends.clear();
+
+  for (uint32_t stage = 0; stage < stage_count; stage++)
+  {
+    for (size_t i = 0; i < phase_systems.size(); i++)
+    {
+      if (stages[i] == stage)
+        order.push_back(static_cast<uint32_t>(i));
+    }
+    ends.push_back(static_cast<uint32_t>(order.size()));
+  }
+}
+
+struct StageJobs
+{
+  const std::vector<Manager::System<Manager::SystemFunction>> *systems;
+  const uint32_t *indices;
+};
+
+static void run_stage_system(void *context, size_t index)
+{
+  const auto &jobs   = *static_cast<const StageJobs *>(context);
+  const auto &system = (*jobs.systems)[jobs.indices[index]];
+  system.function(system.manager);
+}
+
+void Manager::run_stages(Phase phase)
+{
+  const auto &order = stage_systems[phase];
+  auto &pool        = WorkerPool::get();
+
+  uint32_t begin = 0;
+  for (const uint32_t end : stage_ends[phase])
+  {
+    StageJobs jobs{ &systems[phase], order.data() + begin };
+    pool.run(&run_stage_system, &jobs, end - begin);
+    begin = end;
+  }
 }
 
 void Manager::destroy()
@@ -44,14 +201,210 @@ void Manager::destroy()
   }
 }
 
+Manager::Snapshot::~Snapshot()
+{
+  clear();
+}
+
+Manager::Snapshot::Snapshot(Snapshot &&other) noexcept
+  : entities{ std::move(other.entities) }
+  , components{ std::move(other.components) }
+  , memory_usage{ std::exchange(other.memory_usage, 0) }
+{
+  other.entities.clear();
+  other.components.clear();
+}
+
+Manager::Snapshot &Manager::Snapshot::operator=(Snapshot &&other) noexcept
+{
+  if (this != &other)
+  {
+    clear();
+    entities     = std::move(other.entities);
+    components   = std::move(other.components);
+    memory_usage = std::exchange(other.memory_usage, 0);
+    other.entities.clear();
+    other.components.clear();
+  }
+
+  return *this;
+}
+
+void Manager::Snapshot::clear()
+{
+  for (const auto &stored : components)
+    stored.release(stored.components);
+
+  // Entities that are not restored free their slots
+  for (const auto entity : entities)
+    Manager::get().entity_container.release(entity);
+
+  entities.clear();
+  components.clear();
+  memory_usage = 0;
+}
+
+Manager::Snapshot Manager::take_non_persistent_entities()
+{
+  call_destroy();
+
+  Snapshot snapshot;
+  for (size_t entity_index = 0; entity_index < entity_container.entities_count; entity_index++)
+  {
+    const auto entity = entity_container.entities[entity_index];
+    if (!is_persistent(entity))
+      snapshot.entities.push_back(entity);
+  }
+
+  for (const auto &[_, container] : component_containers)
+  {
+    if (container.valid && container.snapshot)
+      container.snapshot(container.manager, snapshot.entities, snapshot);
+  }
+
+  for (const auto entity : snapshot.entities)
+    entity_container.store(entity);
+
+  return snapshot;
+}
+
+void Manager::restore_entities(Snapshot &&snapshot)
+{
+  for (const auto entity : snapshot.entities)
+    entity_container.restore(entity);
+
+  for (const auto &stored : snapshot.components)
+  {
+    auto &container = component_containers[stored.type];
+    assert(container.valid && "Component manager does not exist");
+    stored.restore(container.manager, stored.components);
+  }
+
+  // Restored components and entities are owned by the manager again
+  snapshot.components.clear();
+  snapshot.entities.clear();
+  snapshot.clear();
+}
+
 Entity Manager::EntityContainer::create()
 {
-  Entity entity = previous_entity_id + 1;
+  uint32_t index = 0;
+  if (free_count > 0)
+  {
+    free_count -= 1;
+    index = free_slots[free_count];
+  }
+  else
+  {
+    assert(slot_count < slots.size() && "Entity container is full");
+    index = slot_count;
+    slot_count += 1;
+    slots[index].version = 1;
+  }
+
+  const Entity entity = make_entity(index, slots[index].version);
+  insert(entity);
+  return entity;
+}
+
+void Manager::EntityContainer::remove(Entity entity)
+{
+  if (!contains(entity))
+    return;
+
+  erase(entity);
+  free_slot(slot_index(entity));
+}
+
+void Manager::EntityContainer::store(Entity entity)
+{
+  if (contains(entity))
+    erase(entity);
+}
+
+void Manager::EntityContainer::restore(Entity entity)
+{
+  assert(is_stored(entity) && "Entity is not stored");
+  if (is_stored(entity))
+    insert(entity);
+}
+
+void Manager::EntityContainer::release(Entity entity)
+{
+  if (is_stored(entity))
+    free_slot(slot_index(entity));
+}
+
+void Manager::EntityContainer::insert(Entity entity)
+{
   assert(entities_count < entities.size() && "Entity container is full");
 
-  entities[entities_count] = entity;
+  slots[slot_index(entity)].dense_index = static_cast<uint32_t>(entities_count);
+  entities[entities_count]              = entity;
   entities_count += 1;
+}
 
-  previous_entity_id = entity;
-  return entity;
+void Manager::EntityContainer::erase(Entity entity)
+{
+  const uint32_t dense_index = slots[slot_index(entity)].dense_index;
+  const Entity last          = entities[entities_count - 1];
+
+  entities[dense_index]                 = last;
+  slots[slot_index(last)].dense_index   = dense_index;
+  slots[slot_index(entity)].dense_index = INVALID_SLOT;
+  entities_count -= 1;
+}
+
+void Manager::EntityContainer::free_slot(uint32_t index)
+{
+  // Version 0 is skipped when the version wraps around
+  slots[index].version += 1;
+  if (slots[index].version == 0)
+    slots[index].version = 1;
+  slots[index].components = 0;
+  slots[index].destroyed  = false;
+
+  free_slots[free_count] = index;
+  free_count += 1;
+}
+
+void Manager::sort_render_commands()
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const size_t count = render_commands.size();
+  render_commands_scratch.resize(count);
+
+  RenderCommand *source      = render_commands.data();
+  RenderCommand *destination = render_commands_scratch.data();
+
+  for (int shift = 0; shift < 64 && count > 1; shift += 8)
+  {
+    std::array<size_t, 256> offsets{};
+    for (size_t i = 0; i < count; i++)
+      offsets[(source[i].key >> shift) & 0xFF]++;
+
+    // Every key has the same byte, so this pass would not change the order
+    if (offsets[(source[0].key >> shift) & 0xFF] == count)
+      continue;
+
+    size_t offset = 0;
+    for (auto &bucket : offsets)
+    {
+      const size_t bucket_count = bucket;
+      bucket                    = offset;
+      offset += bucket_count;
+    }
+
+    for (size_t i = 0; i < count; i++)
+      destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+    std::swap(source, destination);
+  }
+
+  if (source != render_commands.data())
+    std::copy(source, source + count, render_commands.data());
+
+  render_stats.command_count = count;
+  render_stats.sort_time     = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
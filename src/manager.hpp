@@ -5,13 +5,17 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdio>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <limits>
 #include <queue>
 #include <set>
 #include <span>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "component.hpp"
 
@@ -22,10 +26,13 @@ using ReferenceIndex = size_t;
 template<typename C>
 struct ComponentReference;
 
-constexpr inline size_t MAX_COMPONENTS_PER_TYPE = 4096;
-constexpr inline Entity ENTITY_START_ID         = 10;
-constexpr inline int DEFAULT_DEPTH              = -9;
-constexpr inline int NEG_INF_DEPTH              = std::numeric_limits<int>::min();
+constexpr inline size_t MAX_ENTITIES = 4096;
+
+// One bit per registered component type, entities keep the bits of the types they have components of
+using ComponentMask                          = uint64_t;
+constexpr inline size_t MAX_COMPONENT_TYPES = std::numeric_limits<ComponentMask>::digits;
+constexpr inline int DEFAULT_DEPTH   = -9;
+constexpr inline int NEG_INF_DEPTH   = std::numeric_limits<int>::min();
 
 #define GEN_HAS_FUNCTION_CONCEPT(func)               \
   template<typename C, typename... Args>             \
@@ -46,8 +53,73 @@ GEN_HAS_FUNCTION_CONCEPT(postupdate);
 GEN_HAS_FUNCTION_CONCEPT(render);
 GEN_HAS_FUNCTION_CONCEPT(collision);
 GEN_HAS_FUNCTION_CONCEPT(destroyed);
+GEN_HAS_FUNCTION_CONCEPT(stored);
+GEN_HAS_FUNCTION_CONCEPT(restored);
 
 GEN_HAS_MEMBER_CONCEPT(depth);
+GEN_HAS_MEMBER_CONCEPT(priority);
+
+// Component types a system reads and writes. Components declare them with
+//   using reads  = ComponentTypes<Interactable>;
+//   using writes = ComponentTypes<Light>;
+// and always write their own type, components that only touch themselves declare an empty list. Systems that declare
+// nothing may touch anything, so they run alone. Systems with disjoint access run concurrently in the update phases.
+template<typename... Cs>
+struct ComponentTypes
+{
+};
+
+template<typename C>
+concept has_reads = requires { typename C::reads; };
+
+template<typename C>
+concept has_writes = requires { typename C::writes; };
+
+template<typename C>
+struct declared_reads
+{
+  using type = ComponentTypes<>;
+};
+
+template<has_reads C>
+struct declared_reads<C>
+{
+  using type = typename C::reads;
+};
+
+template<typename C>
+struct declared_writes
+{
+  using type = ComponentTypes<>;
+};
+
+template<has_writes C>
+struct declared_writes<C>
+{
+  using type = typename C::writes;
+};
+
+template<typename C>
+using declared_reads_t = typename declared_reads<C>::type;
+
+template<typename C>
+using declared_writes_t = typename declared_writes<C>::type;
+
+template<typename C>
+concept has_render_texture = requires(const C c) {
+  { c.render_texture() } -> std::convertible_to<unsigned int>;
+};
+
+template<typename C>
+concept has_memory_usage = requires(const C c) {
+  { c.memory_usage() } -> std::convertible_to<size_t>;
+};
+
+template<typename C>
+concept has_render_bounds = requires(const C c) {
+  { c.render_bounds().x } -> std::convertible_to<float>;
+  { c.render_bounds().width } -> std::convertible_to<float>;
+};
 
 struct Manager final
 {
@@ -56,10 +128,117 @@ struct Manager final
   void unregister_all();
   void destroy();
 
-  struct DrawCall
+  // Commands are sorted by key: depth (farther first), then texture, then material (render system order)
+  struct RenderCommand
+  {
+    uint64_t key;
+    void *component;
+    void (*draw)(void *);
+
+    [[nodiscard]] static constexpr uint64_t make_key(int depth, unsigned int texture, uint8_t material)
+    {
+      // Flipping the sign bit makes the depth order unsigned, inverting it puts higher depth first
+      const uint32_t depth_bits = ~(static_cast<uint32_t>(depth) ^ 0x80000000u);
+      return (static_cast<uint64_t>(depth_bits) << 32) | (static_cast<uint64_t>(texture & 0xFFFFFF) << 8) | material;
+    }
+
+    [[nodiscard]] constexpr int depth() const
+    {
+      return static_cast<int>(~static_cast<uint32_t>(key >> 32) ^ 0x80000000u);
+    }
+  };
+  static_assert(std::is_trivially_copyable_v<RenderCommand>);
+
+  struct RenderStats
+  {
+    size_t command_count{ 0 };
+    size_t visible_count{ 0 };
+    size_t culled_count{ 0 };
+    double sort_time{ 0.0 };
+  };
+
+  // World rectangle visible through the camera. Components with render_bounds() outside of it are culled
+  // before a render command is emitted, components without bounds are always drawn.
+  struct RenderView
+  {
+    float left{ 0.0f };
+    float top{ 0.0f };
+    float right{ 0.0f };
+    float bottom{ 0.0f };
+    bool enabled{ false };
+
+    [[nodiscard]] constexpr bool overlaps(float x, float y, float width, float height) const
+    {
+      return !enabled || (x + width >= left && x <= right && y + height >= top && y <= bottom);
+    }
+  };
+
+  // Components of entities that were taken out of the manager without being destroyed. Restoring brings the
+  // entities back with the same ids and without calling init() again. Components are notified with stored() and
+  // restored() when they define them, components that are dropped with the snapshot get destroyed().
+  struct Snapshot
+  {
+    struct Components
+    {
+      void *components{ nullptr };
+      void (*restore)(void *manager, void *components){ nullptr };
+      void (*release)(void *components){ nullptr };
+      ComponentType type{ 0 };
+    };
+
+    Snapshot() = default;
+    ~Snapshot();
+
+    Snapshot(const Snapshot &)            = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+    Snapshot(Snapshot &&) noexcept;
+    Snapshot &operator=(Snapshot &&) noexcept;
+
+    void clear();
+
+    [[nodiscard]] inline bool empty() const
+    {
+      return entities.empty();
+    }
+
+    std::vector<Entity> entities;
+    std::vector<Components> components;
+    // Component sizes plus what components report with memory_usage()
+    size_t memory_usage{ 0 };
+  };
+
+  using SnapshotFunction = void (*)(void *, const std::vector<Entity> &, Snapshot &);
+
+  enum Phase
+  {
+    Init,
+    Preupdate,
+    Update,
+    Postupdate,
+    Render,
+    PhaseCount
+  };
+
+  using SystemFunction    = void (*)(void *);
+  using EntityFunction    = void (*)(void *, Entity);
+  using EntitiesFunction  = void (*)(void *, const std::vector<Entity> &);
+  using CollisionFunction = void (*)(void *, Entity, Entity);
+  // Fills the masks of the declared component types, false when one of them is not registered
+  using AccessFunction = bool (*)(ComponentMask &reads, ComponentMask &writes);
+
+  // Systems run in descending priority order (C::priority, 0 by default), ties run in type id order
+  template<typename Function>
+  struct System
   {
-    int depth{ 0 };
-    std::function<void()> render;
+    Function function{ nullptr };
+    void *manager{ nullptr };
+    ComponentType type{ 0 };
+    int priority{ 0 };
+    ComponentMask mask{ 0 };
+    AccessFunction access{ nullptr };
+    // Resolved from access when the systems are built, all bits when nothing is declared
+    ComponentMask reads{ 0 };
+    ComponentMask writes{ 0 };
   };
 
   template<typename C>
@@ -69,15 +248,41 @@ struct Manager final
 
     void push(Entity entity, C &&component)
     {
-      static_assert(sizeof(C) < COMPONENT_PADDING_SIZE);
-      static_assert(sizeof(ComponentPadded<C>) == COMPONENT_PADDING_SIZE);
-      assert(components_count < components.size());
+#if !defined(PACKED_COMPONENTS)
+      assert(components_count < components.capacity());
+#endif
+
+      if (components_count >= init_called.size())
+      {
+        const size_t new_size = std::max<size_t>(64, init_called.size() * 2);
+        init_called.resize(new_size);
+        index_components.resize(new_size);
+        next_entity_component.resize(new_size);
+        previous_entity_component.resize(new_size);
+      }
 
-      component.entity              = entity;
-      components[components_count]  = std::move(component);
+      component.entity = entity;
+      components.assign(components_count, std::move(component));
       init_called[components_count] = false;
-      component_indices.push_back(components_count);
-      index_components[components_count] = component_indices.size() - 1;
+
+      ReferenceIndex slot = component_indices.size();
+      if (!free_references.empty())
+      {
+        slot = free_references.back();
+        free_references.pop_back();
+        component_indices[slot] = components_count;
+      }
+      else
+      {
+        component_indices.push_back(components_count);
+        reference_generations.push_back(0);
+      }
+      index_components[components_count] = make_reference(slot, reference_generations[slot]);
+
+      if constexpr (has_init<C>)
+        pending_init.push_back(index_components[components_count]);
+
+      link(entity, components_count);
 
       components_count += 1;
     }
@@ -90,28 +295,129 @@ struct Manager final
     [[nodiscard]] inline C &get(ComponentIndex component_index)
     {
       assert(component_index < components_count);
-      return components[component_index].component;
+      return components[component_index];
+    }
+
+    [[nodiscard]] inline size_t memory_usage() const
+    {
+      return components.memory_usage();
     }
 
     void remove(ComponentIndex component_index)
     {
       assert(component_index < components_count);
 
-      const auto reference_index         = get_reference_index(component_index);
-      component_indices[reference_index] = INVALID_INDEX;
+      free_reference(get_reference_index(component_index));
+
+      unlink(component_index);
 
       if (components_count > 1)
       {
-        std::swap(components[component_index], components[components_count - 1]);
-        std::swap(init_called[component_index], init_called[components_count - 1]);
-        const auto swapped_reference_index         = get_reference_index(components_count - 1);
-        component_indices[swapped_reference_index] = component_index;
-        index_components[component_index]          = swapped_reference_index;
+        const auto last_index = components_count - 1;
+        if (component_index != last_index)
+          relink(last_index, component_index);
+
+        components.swap(component_index, last_index);
+        std::swap(init_called[component_index], init_called[last_index]);
+        const auto swapped_reference_index                        = get_reference_index(last_index);
+        component_indices[reference_slot(swapped_reference_index)] = component_index;
+        index_components[component_index]                         = swapped_reference_index;
       }
 
       components_count -= 1;
     }
 
+    // Removes all components of the entities. A few components are swapped out one by one, larger batches are
+    // marked and compacted in a single pass that keeps the order of the remaining components.
+    void remove_entities(const std::vector<Entity> &entities)
+    {
+      size_t removed_count = 0;
+      for (const auto entity : entities)
+      {
+        for (auto i = first_of(entity); i != INVALID_INDEX; i = next_of(i))
+          removed_count += 1;
+      }
+
+      if (removed_count == 0)
+        return;
+
+      if (removed_count * COMPACT_RATIO < components_count)
+      {
+        for (const auto entity : entities)
+        {
+          for (auto i = first_of(entity); i != INVALID_INDEX; i = first_of(entity))
+            remove(i);
+        }
+        return;
+      }
+
+      removing.assign(components_count, false);
+      for (const auto entity : entities)
+      {
+        for (auto i = first_of(entity); i != INVALID_INDEX; i = next_of(i))
+        {
+          removing[i] = true;
+          free_reference(get_reference_index(i));
+        }
+        entity_components[EntityContainer::slot_index(entity)] = INVALID_INDEX;
+      }
+
+      // Remaining components move down into the gaps, removed ones end up past the new count
+      remap.resize(components_count);
+      ComponentIndex write_index = 0;
+      for (ComponentIndex i = 0; i < components_count; i++)
+      {
+        if (removing[i])
+          continue;
+
+        remap[i] = write_index;
+        if (write_index != i)
+        {
+          components.swap(write_index, i);
+          init_called[write_index]               = init_called[i];
+          index_components[write_index]          = index_components[i];
+          next_entity_component[write_index]     = next_entity_component[i];
+          previous_entity_component[write_index] = previous_entity_component[i];
+
+          if (previous_entity_component[write_index] == INVALID_INDEX)
+            entity_components[EntityContainer::slot_index(components[write_index].entity)] = write_index;
+        }
+        write_index += 1;
+      }
+
+      components_count = write_index;
+      for (ComponentIndex i = 0; i < components_count; i++)
+      {
+        component_indices[reference_slot(index_components[i])] = i;
+        if (next_entity_component[i] != INVALID_INDEX)
+          next_entity_component[i] = remap[next_entity_component[i]];
+        if (previous_entity_component[i] != INVALID_INDEX)
+          previous_entity_component[i] = remap[previous_entity_component[i]];
+      }
+    }
+
+    // First component of the entity in insertion order, or INVALID_INDEX
+    [[nodiscard]] inline ComponentIndex first_of(Entity entity) const
+    {
+      const auto slot = EntityContainer::slot_index(entity);
+      if (slot >= entity_components.size())
+        return INVALID_INDEX;
+
+      // The slot may belong to a newer version of the entity
+      const auto component_index = entity_components[slot];
+      if (component_index == INVALID_INDEX || components[component_index].entity != entity)
+        return INVALID_INDEX;
+
+      return component_index;
+    }
+
+    // Next component of the same entity, or INVALID_INDEX
+    [[nodiscard]] inline ComponentIndex next_of(ComponentIndex component_index) const
+    {
+      assert(component_index < components_count);
+      return next_entity_component[component_index];
+    }
+
     void set_init_called(ComponentIndex component_index)
     {
       assert(component_index < components_count);
@@ -124,10 +430,30 @@ struct Manager final
       return init_called[component_index];
     }
 
+    // Calls init() of the components pushed since the last call, including the ones pushed by these init() calls
+    void init_pending()
+    {
+      for (size_t i = 0; i < pending_init.size(); i++)
+      {
+        const auto component_index = get_component_index(pending_init[i]);
+        if (component_index == INVALID_INDEX || was_init_called(component_index))
+          continue;
+
+        get(component_index).init();
+        set_init_called(component_index);
+      }
+
+      pending_init.clear();
+    }
+
+    // INVALID_INDEX when the component was removed, even when its slot is used by another component now
     [[nodiscard]] inline ComponentIndex get_component_index(ReferenceIndex reference_index) const
     {
-      assert(reference_index < component_indices.size());
-      return component_indices[reference_index];
+      const auto slot = reference_slot(reference_index);
+      assert(slot < component_indices.size());
+      if (reference_generations[slot] != reference_generation(reference_index))
+        return INVALID_INDEX;
+      return component_indices[slot];
     }
 
     [[nodiscard]] inline ReferenceIndex get_reference_index(ComponentIndex component_index) const
@@ -136,12 +462,117 @@ struct Manager final
       return index_components[component_index];
     }
 
+    // Reference slots ever used, removed components return their slot to the free list
+    [[nodiscard]] inline size_t reference_count() const
+    {
+      return component_indices.size();
+    }
+
   private:
-    std::array<ComponentPadded<C>, MAX_COMPONENTS_PER_TYPE> components;
-    std::array<bool, MAX_COMPONENTS_PER_TYPE> init_called;
+    // Reference indices hold a slot in the low and a generation in the high half. Slots of removed components
+    // are reused with the next generation, so references to removed components are detected.
+    static constexpr size_t REFERENCE_SLOT_BITS         = sizeof(ReferenceIndex) * 4;
+    static constexpr ReferenceIndex REFERENCE_SLOT_MASK = (ReferenceIndex{ 1 } << REFERENCE_SLOT_BITS) - 1;
+    static_assert(MAX_COMPONENTS_PER_TYPE < REFERENCE_SLOT_MASK, "Reference slots are too small");
+
+    [[nodiscard]] static constexpr ReferenceIndex reference_slot(ReferenceIndex reference_index)
+    {
+      return reference_index & REFERENCE_SLOT_MASK;
+    }
+
+    [[nodiscard]] static constexpr ReferenceIndex reference_generation(ReferenceIndex reference_index)
+    {
+      return reference_index >> REFERENCE_SLOT_BITS;
+    }
+
+    [[nodiscard]] static constexpr ReferenceIndex make_reference(ReferenceIndex slot, ReferenceIndex generation)
+    {
+      return (generation << REFERENCE_SLOT_BITS) | slot;
+    }
+
+    // Batches that remove fewer than one in COMPACT_RATIO components are not compacted
+    static constexpr size_t COMPACT_RATIO = 8;
+
+    void free_reference(ReferenceIndex reference_index)
+    {
+      const auto slot             = reference_slot(reference_index);
+      component_indices[slot]     = INVALID_INDEX;
+      reference_generations[slot] = (reference_generations[slot] + 1) & REFERENCE_SLOT_MASK;
+      free_references.push_back(slot);
+    }
+
+    void link(Entity entity, ComponentIndex component_index)
+    {
+      next_entity_component[component_index]     = INVALID_INDEX;
+      previous_entity_component[component_index] = INVALID_INDEX;
+
+      const auto slot = EntityContainer::slot_index(entity);
+      if (slot >= entity_components.size())
+        entity_components.resize(slot + 1, INVALID_INDEX);
+
+      if (entity_components[slot] == INVALID_INDEX)
+      {
+        entity_components[slot] = component_index;
+        return;
+      }
+
+      auto last = entity_components[slot];
+      while (next_entity_component[last] != INVALID_INDEX)
+        last = next_entity_component[last];
+
+      next_entity_component[last]                = component_index;
+      previous_entity_component[component_index] = last;
+    }
+
+    void unlink(ComponentIndex component_index)
+    {
+      const auto previous = previous_entity_component[component_index];
+      const auto next     = next_entity_component[component_index];
+
+      if (previous != INVALID_INDEX)
+        next_entity_component[previous] = next;
+      else if (next != INVALID_INDEX)
+        entity_components[EntityContainer::slot_index(components[component_index].entity)] = next;
+      else
+        entity_components[EntityContainer::slot_index(components[component_index].entity)] = INVALID_INDEX;
+
+      if (next != INVALID_INDEX)
+        previous_entity_component[next] = previous;
+    }
+
+    // Points the links of the component at from_index to its new slot before it is moved there
+    void relink(ComponentIndex from_index, ComponentIndex to_index)
+    {
+      const auto previous = previous_entity_component[from_index];
+      const auto next     = next_entity_component[from_index];
+
+      if (previous != INVALID_INDEX)
+        next_entity_component[previous] = to_index;
+      else
+        entity_components[EntityContainer::slot_index(components[from_index].entity)] = to_index;
+
+      if (next != INVALID_INDEX)
+        previous_entity_component[next] = to_index;
+
+      previous_entity_component[to_index] = previous;
+      next_entity_component[to_index]     = next;
+    }
+
+    ComponentStorage<C> components;
+    std::vector<uint8_t> init_called;
     size_t components_count{ 0 };
-    std::vector<ComponentIndex> component_indices;                        // reference index -> component index
-    std::array<ReferenceIndex, MAX_COMPONENTS_PER_TYPE> index_components; // component index -> reference index
+    std::vector<ComponentIndex> component_indices;                // reference slot -> component index
+    std::vector<ReferenceIndex> reference_generations;            // reference slot -> generation
+    std::vector<ReferenceIndex> free_references;                  // unused reference slots
+    std::vector<ReferenceIndex> index_components;                 // component index -> reference index
+    std::vector<ComponentIndex> entity_components;                // entity slot -> first component index
+    std::vector<ComponentIndex> next_entity_component;
+    std::vector<ComponentIndex> previous_entity_component;
+    // References of pushed components that wait for init(), removed ones are skipped
+    std::vector<ReferenceIndex> pending_init;
+    // Scratch space of remove_entities
+    std::vector<bool> removing;
+    std::vector<ComponentIndex> remap;
     friend struct Manager;
   };
 
@@ -156,39 +587,43 @@ private:
       return *static_cast<ComponentManager<C> *>(manager);
     }
 
-    std::function<void()> init{ nullptr };
-    std::function<void()> preupdate{ nullptr };
-    std::function<void()> update{ nullptr };
-    std::function<void()> postupdate{ nullptr };
-    std::function<void()> render{ nullptr };
-    std::function<void(Entity, Entity)> collision{ nullptr };
-    std::function<void(Entity)> remove{ nullptr };
-    std::function<void(Entity)> destroyed{ nullptr };
+    std::array<SystemFunction, PhaseCount> systems{};
+    CollisionFunction collision{ nullptr };
+    EntityFunction remove{ nullptr };
+    EntitiesFunction remove_entities{ nullptr };
+    EntityFunction destroyed{ nullptr };
+    SnapshotFunction snapshot{ nullptr };
+    AccessFunction access{ nullptr };
+    int priority{ 0 };
 
   private:
     bool valid{ false };
     ComponentType id{ 0 };
+    // Assigned once, so it stays the same when the library is reloaded
+    ComponentMask mask{ 0 };
     void *manager{ nullptr };
 
     inline void uninitialize()
     {
-      init       = nullptr;
-      preupdate  = nullptr;
-      update     = nullptr;
-      postupdate = nullptr;
-      render     = nullptr;
-      collision  = nullptr;
-      remove     = nullptr;
-      destroyed  = nullptr;
+      systems.fill(nullptr);
+      collision       = nullptr;
+      remove          = nullptr;
+      remove_entities = nullptr;
+      destroyed       = nullptr;
+      snapshot        = nullptr;
+      access          = nullptr;
+      priority        = 0;
     }
 
     friend struct Manager;
   };
 
+  // Entities are handles with a slot index in the low and a version in the high 32 bits. Freed slots are reused
+  // with the next version, so a handle of a destroyed entity never matches the entity created in its place.
   struct EntityContainer
   {
-    Entity entity{ INVALID_ENTITY };
-    std::array<Entity, 4096> entities;
+    // Existing entities in no particular order
+    std::array<Entity, MAX_ENTITIES> entities;
     size_t entities_count{ 0 };
 
     EntityContainer() = default;
@@ -200,31 +635,183 @@ private:
 
     [[nodiscard]] Entity create();
 
-    void remove(Entity entity)
+    // Destroys the entity and frees its slot
+    void remove(Entity entity);
+
+    // The entity stops existing but keeps its slot, so it can be restored with the same handle
+    void store(Entity entity);
+
+    // Adds back an entity that was taken out with store
+    void restore(Entity entity);
+
+    // Frees the slot of a stored entity that will not be restored
+    void release(Entity entity);
+
+    // Types the entity has components of, stored entities keep theirs until they are restored
+    [[nodiscard]] inline ComponentMask components(Entity entity) const
     {
-      auto it = std::find(std::begin(entities), std::begin(entities) + entities_count, entity);
-      if (it == std::end(entities) || it == std::begin(entities) + entities_count)
-      {
-        // Entity not found
-        return;
-      }
-      std::swap(*it, entities[entities_count - 1]);
-      entities_count -= 1;
+      const auto index = slot_index(entity);
+      return index < slot_count && slots[index].version == version(entity) ? slots[index].components : 0;
+    }
+
+    inline void add_components(Entity entity, ComponentMask mask)
+    {
+      if (contains(entity))
+        slots[slot_index(entity)].components |= mask;
+    }
+
+    inline void remove_components(Entity entity, ComponentMask mask)
+    {
+      if (contains(entity))
+        slots[slot_index(entity)].components &= ~mask;
     }
 
-    [[nodiscard]] bool contains(Entity entity) const
+    // Marks the entity for the destruction batch, false when it does not exist or is marked already
+    [[nodiscard]] inline bool mark_destroyed(Entity entity)
     {
-      if (entity == INVALID_ENTITY)
+      if (!contains(entity) || slots[slot_index(entity)].destroyed)
         return false;
 
-      assert(entities_count < entities.size());
+      slots[slot_index(entity)].destroyed = true;
+      return true;
+    }
+
+    [[nodiscard]] inline bool contains(Entity entity) const
+    {
+      const auto index = slot_index(entity);
+      return index < slot_count && slots[index].version == version(entity) && slots[index].dense_index != INVALID_SLOT;
+    }
+
+    // Slots are below MAX_ENTITIES, so they can index per-entity arrays
+    [[nodiscard]] static constexpr uint32_t slot_index(Entity entity)
+    {
+      return static_cast<uint32_t>(entity & 0xFFFFFFFF);
+    }
+
+  private:
+    static constexpr uint32_t INVALID_SLOT = std::numeric_limits<uint32_t>::max();
+
+    struct Slot
+    {
+      uint32_t version{ 0 };
+      // Position in entities, INVALID_SLOT when the entity does not exist
+      uint32_t dense_index{ INVALID_SLOT };
+      ComponentMask components{ 0 };
+      bool destroyed{ false };
+    };
+
+    [[nodiscard]] static constexpr uint32_t version(Entity entity)
+    {
+      return static_cast<uint32_t>(entity >> 32);
+    }
+
+    // Versions start at 1, so no handle is INVALID_ENTITY
+    [[nodiscard]] static constexpr Entity make_entity(uint32_t index, uint32_t entity_version)
+    {
+      return (static_cast<Entity>(entity_version) << 32) | index;
+    }
+
+    [[nodiscard]] inline bool is_stored(Entity entity) const
+    {
+      const auto index = slot_index(entity);
+      return index < slot_count && slots[index].version == version(entity) && slots[index].dense_index == INVALID_SLOT;
+    }
+
+    void insert(Entity entity);
+    void erase(Entity entity);
+    void free_slot(uint32_t index);
+
+    std::array<Slot, MAX_ENTITIES> slots;
+    uint32_t slot_count{ 0 };
+    std::array<uint32_t, MAX_ENTITIES> free_slots;
+    uint32_t free_count{ 0 };
+  };
+
+  // Entities that have components of all the types, with the first component of each type. The type with the
+  // fewest components drives the iteration, the other components are found through the entity slot.
+  // Components must not be added or removed while iterating.
+  template<typename... Cs>
+  struct View
+  {
+    struct Iterator
+    {
+      [[nodiscard]] inline std::tuple<Cs &...> operator*() const
+      {
+        const Entity entity = view->driver_entity(view->driver, index);
+        return { std::get<ComponentManager<Cs> *>(view->managers)->get(
+          std::get<ComponentManager<Cs> *>(view->managers)->first_of(entity))... };
+      }
+
+      inline Iterator &operator++()
+      {
+        index = view->next(index + 1);
+        return *this;
+      }
+
+      [[nodiscard]] inline bool operator!=(const Iterator &other) const
+      {
+        return index != other.index;
+      }
+
+      const View *view{ nullptr };
+      size_t index{ 0 };
+    };
+
+    View(const EntityContainer &entities, ComponentMask components_mask, ComponentManager<Cs> *...component_managers)
+      : managers{ component_managers... }
+      , entity_container{ &entities }
+      , mask{ components_mask }
+    {
+      (select_driver(component_managers), ...);
+    }
+
+    [[nodiscard]] inline Iterator begin() const
+    {
+      return Iterator{ this, next(0) };
+    }
 
-      return std::find(std::begin(entities), std::begin(entities) + entities_count, entity) !=
-             std::begin(entities) + entities_count;
+    [[nodiscard]] inline Iterator end() const
+    {
+      return Iterator{ this, driver_count };
     }
 
   private:
-    Entity previous_entity_id{ ENTITY_START_ID };
+    template<typename C>
+    inline void select_driver(ComponentManager<C> *component_manager)
+    {
+      if (driver && component_manager->count() >= driver_count)
+        return;
+
+      driver        = component_manager;
+      driver_count  = component_manager->count();
+      driver_entity = &first_component_entity<C>;
+    }
+
+    // Entity of the driver component, INVALID_ENTITY when it is not the first component of its entity
+    template<typename C>
+    [[nodiscard]] static Entity first_component_entity(void *manager, size_t index)
+    {
+      auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+      const Entity entity     = component_manager.get(index).entity;
+      return component_manager.first_of(entity) == index ? entity : INVALID_ENTITY;
+    }
+
+    [[nodiscard]] inline size_t next(size_t index) const
+    {
+      for (; index < driver_count; index++)
+      {
+        if ((entity_container->components(driver_entity(driver, index)) & mask) == mask)
+          return index;
+      }
+      return driver_count;
+    }
+
+    std::tuple<ComponentManager<Cs> *...> managers;
+    const EntityContainer *entity_container{ nullptr };
+    ComponentMask mask{ 0 };
+    void *driver{ nullptr };
+    size_t driver_count{ 0 };
+    Entity (*driver_entity)(void *, size_t){ nullptr };
   };
 
   inline Manager() = default;
@@ -247,6 +834,11 @@ private:
     return entity_container.contains(entity);
   }
 
+  [[nodiscard]] inline size_t entity_count() const
+  {
+    return entity_container.entities_count;
+  }
+
   template<typename C>
   void register_component()
   {
@@ -259,133 +851,313 @@ private:
       container.id              = C::id();
       container.manager         = new (std::malloc(manager_size)) ComponentManager<C>();
       container.valid           = true;
+
+      assert(component_type_count < MAX_COMPONENT_TYPES && "Too many component types");
+      container.mask = ComponentMask{ 1 } << component_type_count;
+      component_type_count += 1;
     }
 
-    auto &manager           = Manager::get();
-    auto &component_manager = manager.component_containers[C::id()].template get_manager<C>();
+    auto &component_manager = container.template get_manager<C>();
+
+    // Storage outlives the library, so it has to match the layout of the newly loaded component
+    component_manager.components.restride();
+
+    if constexpr (has_priority<C>)
+      container.priority = C::priority;
 
     if constexpr (has_init<C>)
     {
-      has_new_init   = true;
-      container.init = [&]()
-      {
-        for (size_t i = 0; i < component_manager.count(); i++)
-        {
-          auto &component = component_manager.get(i);
-          if (!component_manager.was_init_called(i))
-          {
-            component.init();
-            component_manager.set_init_called(i);
-          }
-        }
-      };
-      init_components.insert(C::id());
+      has_new_init                   = true;
+      container.systems[Phase::Init] = &init_system<C>;
     }
 
     if constexpr (has_preupdate<C>)
-    {
-      container.preupdate = [&]()
-      {
-        for (size_t i = 0; i < component_manager.count(); i++)
-          component_manager.get(i).preupdate();
-      };
-      preupdate_components.insert(C::id());
-    }
+      container.systems[Phase::Preupdate] = &preupdate_system<C>;
 
     if constexpr (has_update<C>)
-    {
-      container.update = [&]()
-      {
-        for (size_t i = 0; i < component_manager.count(); i++)
-          component_manager.get(i).update();
-      };
-      update_components.insert(C::id());
-    }
+      container.systems[Phase::Update] = &update_system<C>;
 
     if constexpr (has_postupdate<C>)
-    {
-      container.postupdate = [&]()
-      {
-        for (size_t i = 0; i < component_manager.count(); i++)
-          component_manager.get(i).postupdate();
-      };
-      postupdate_components.insert(C::id());
-    }
+      container.systems[Phase::Postupdate] = &postupdate_system<C>;
 
     if constexpr (has_render<C>)
     {
-      last_draw_call_index = std::numeric_limits<size_t>::max();
-      container.render     = [&]()
-      {
-        for (size_t i = 0; i < component_manager.count(); i++)
-        {
-          auto &component = component_manager.get(i);
-          if constexpr (has_depth<C>)
-          {
-            draw_calls.emplace_back(DrawCall{ component.depth, [&]() { component.render(); } });
-          }
-          else
-          {
-            draw_calls.emplace_back(DrawCall{ DEFAULT_DEPTH, [&]() { component.render(); } });
-          }
-        }
-      };
-      render_components.insert(C::id());
+      last_draw_call_index             = std::numeric_limits<size_t>::max();
+      container.systems[Phase::Render] = &render_system<C>;
     }
 
     if constexpr (has_collision<C, Entity>)
+      container.collision = &collision_system<C>;
+
+    container.remove          = &remove_system<C>;
+    container.remove_entities = &remove_entities_system<C>;
+
+    if constexpr (has_destroyed<C>)
+      container.destroyed = &destroyed_system<C>;
+
+    container.snapshot = &snapshot_system<C>;
+
+    if constexpr (has_reads<C> || has_writes<C>)
+      container.access = &component_access<C>;
+
+    systems_dirty = true;
+  }
+
+  template<typename C>
+  [[nodiscard]] static bool type_mask(ComponentMask &mask)
+  {
+    const auto &containers = Manager::get().component_containers;
+    const auto it          = containers.find(C::id());
+    if (it == containers.end() || !it->second.valid)
+      return false;
+
+    mask |= it->second.mask;
+    return true;
+  }
+
+  template<typename... Cs>
+  [[nodiscard]] static bool types_mask(ComponentTypes<Cs...>, ComponentMask &mask)
+  {
+    return (type_mask<Cs>(mask) && ...);
+  }
+
+  template<typename Reads, typename Writes>
+  [[nodiscard]] static bool system_access(ComponentMask &reads, ComponentMask &writes)
+  {
+    return types_mask(Reads{}, reads) && types_mask(Writes{}, writes);
+  }
+
+  template<typename C>
+  [[nodiscard]] static bool component_access(ComponentMask &reads, ComponentMask &writes)
+  {
+    return system_access<declared_reads_t<C>, declared_writes_t<C>>(reads, writes) &&
+           types_mask(ComponentTypes<C>{}, writes);
+  }
+
+  template<typename C>
+  static void init_system(void *manager)
+  {
+    static_cast<ComponentManager<C> *>(manager)->init_pending();
+  }
+
+  template<typename C>
+  static void preupdate_system(void *manager)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    for (size_t i = 0; i < component_manager.count(); i++)
+      component_manager.get(i).preupdate();
+  }
+
+  template<typename C>
+  static void update_system(void *manager)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    for (size_t i = 0; i < component_manager.count(); i++)
+      component_manager.get(i).update();
+  }
+
+  template<typename C>
+  static void postupdate_system(void *manager)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    for (size_t i = 0; i < component_manager.count(); i++)
+      component_manager.get(i).postupdate();
+  }
+
+  template<typename C>
+  static void render_system(void *manager)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    auto &instance          = Manager::get();
+    const uint8_t material  = instance.render_material;
+
+    for (size_t i = 0; i < component_manager.count(); i++)
     {
-      container.collision = [&](Entity owner, Entity collider)
+      auto &component = component_manager.get(i);
+
+      if constexpr (has_render_bounds<C>)
       {
-        for (size_t i = 0; i < component_manager.count(); i++)
+        const auto bounds = component.render_bounds();
+        if (!instance.render_view.overlaps(bounds.x, bounds.y, bounds.width, bounds.height))
         {
-          auto &component = component_manager.get(i);
-          if (component.entity == owner)
-            component.collision(collider);
+          instance.render_stats.culled_count++;
+          continue;
         }
-      };
-      collision_components.insert(C::id());
+      }
+
+      int depth = DEFAULT_DEPTH;
+      if constexpr (has_depth<C>)
+        depth = component.depth;
+
+      unsigned int texture = 0;
+      if constexpr (has_render_texture<C>)
+        texture = component.render_texture();
+
+      instance.render_commands.push_back(
+        RenderCommand{ RenderCommand::make_key(depth, texture, material), &component, &draw_component<C> });
     }
+  }
 
-    container.remove = [&](Entity entity)
+  template<typename C>
+  static void draw_component(void *component)
+  {
+    static_cast<C *>(component)->render();
+  }
+
+  template<typename C>
+  static void collision_system(void *manager, Entity owner, Entity collider)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    for (auto i = component_manager.first_of(owner); i != INVALID_INDEX; i = component_manager.next_of(i))
+      component_manager.get(i).collision(collider);
+  }
+
+  template<typename C>
+  static void remove_system(void *manager, Entity entity)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    for (auto i = component_manager.first_of(entity); i != INVALID_INDEX; i = component_manager.first_of(entity))
+      component_manager.remove(i);
+  }
+
+  template<typename C>
+  static void remove_entities_system(void *manager, const std::vector<Entity> &entities)
+  {
+    static_cast<ComponentManager<C> *>(manager)->remove_entities(entities);
+  }
+
+  template<typename C>
+  static void destroyed_system(void *manager, Entity entity)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    for (auto i = component_manager.first_of(entity); i != INVALID_INDEX; i = component_manager.next_of(i))
+      component_manager.get(i).destroyed();
+  }
+
+  template<typename C>
+  struct StoredComponent
+  {
+    C component;
+    bool init_called{ false };
+  };
+
+  template<typename C>
+  static void snapshot_system(void *manager, const std::vector<Entity> &entities, Snapshot &snapshot)
+  {
+    auto &component_manager                 = *static_cast<ComponentManager<C> *>(manager);
+    std::vector<StoredComponent<C>> *stored = nullptr;
+
+    for (const auto entity : entities)
     {
-      for (size_t i = 0; i < component_manager.count();)
+      for (auto i = component_manager.first_of(entity); i != INVALID_INDEX; i = component_manager.first_of(entity))
       {
-        if (component_manager.get(i).entity == entity)
-          component_manager.remove(i);
-        else
-          i++;
+        auto &component = component_manager.get(i);
+        if constexpr (has_stored<C>)
+          component.stored();
+
+        if (!stored)
+          stored = new std::vector<StoredComponent<C>>();
+        stored->push_back(StoredComponent<C>{ std::move(component), component_manager.was_init_called(i) });
+
+        snapshot.memory_usage += sizeof(C);
+        if constexpr (has_memory_usage<C>)
+          snapshot.memory_usage += stored->back().component.memory_usage();
+
+        component_manager.remove(i);
       }
-    };
+    }
+
+    if (stored)
+      snapshot.components.push_back({ stored, &restore_components<C>, &release_components<C>, C::id() });
+  }
+
+  template<typename C>
+  static void restore_components(void *manager, void *components)
+  {
+    auto &component_manager = *static_cast<ComponentManager<C> *>(manager);
+    auto *stored            = static_cast<std::vector<StoredComponent<C>> *>(components);
+
+    for (auto &[component, init_called] : *stored)
+    {
+      const Entity entity = component.entity;
+      component_manager.push(entity, std::move(component));
+
+      const auto component_index = component_manager.count() - 1;
+      if (init_called)
+        component_manager.set_init_called(component_index);
+      else if constexpr (has_init<C>)
+        Manager::get().has_new_init = true;
+
+      if constexpr (has_restored<C>)
+        component_manager.get(component_index).restored();
+    }
+
+    delete stored;
+  }
+
+  template<typename C>
+  static void release_components(void *components)
+  {
+    auto *stored = static_cast<std::vector<StoredComponent<C>> *>(components);
 
     if constexpr (has_destroyed<C>)
     {
-      container.destroyed = [&](Entity entity)
-      {
-        for (size_t i = 0; i < component_manager.count(); i++)
-        {
-          auto &component = component_manager.get(i);
-          if (component.entity == entity)
-            component.destroyed();
-        }
-      };
-      destroyed_components.insert(C::id());
+      for (auto &entry : *stored)
+        entry.component.destroyed();
     }
+
+    delete stored;
   }
 
+  // Flattens the registered containers into per-phase arrays, sorted by priority
+  void build_systems();
+
+  // Groups the systems of a phase into stages, systems in the same stage touch disjoint component types
+  void build_stages(Phase phase);
+
+  // Runs the stages of a phase one after another, the systems of a stage run concurrently on the worker pool
+  void run_stages(Phase phase);
+
 public:
+  inline void run_systems(Phase phase)
+  {
+    if (systems_dirty)
+      build_systems();
+
+    // Init adds components and render appends to the shared command buffer, so they always run serially
+    if (serial_systems || phase == Phase::Init || phase == Phase::Render)
+    {
+      for (const auto &system : systems[phase])
+        system.function(system.manager);
+      return;
+    }
+
+    run_stages(phase);
+  }
+
+  // Systems that are not bound to a component type, like systems over a view. They are cleared when the library is
+  // unloaded and registered again by RegisterSystem when it is loaded.
+  inline void register_system(Phase phase, SystemFunction function, int priority, AccessFunction access = nullptr)
+  {
+    registered_systems[phase].push_back({ function, nullptr, 0, priority, 0, access });
+    systems_dirty = true;
+  }
+
+  inline void call_collision(Entity owner, Entity collider)
+  {
+    if (systems_dirty)
+      build_systems();
+
+    for (const auto &system : collision_systems)
+      system.function(system.manager, owner, collider);
+  }
+
   void call_init()
   {
     while (has_new_init)
     {
       has_new_init = false;
-
-      for (auto &component_id : init_components)
-      {
-        auto &container = component_containers[component_id];
-        if (container.init)
-          container.init();
-      }
+      run_systems(Phase::Init);
     }
   }
 
@@ -393,61 +1165,111 @@ public:
   {
     assert(created && "Manager not created");
 
+    // Entities queued by destroyed() callbacks are destroyed in the next batch
     while (!entity_destroy_queue.empty())
     {
-      auto entity = entity_destroy_queue.front();
+      if (systems_dirty)
+        build_systems();
 
-      for (auto &component_type : destroyed_components)
+      destroy_batch.clear();
+      while (!entity_destroy_queue.empty())
       {
-        auto &container = component_containers[component_type];
-        if (container.valid && container.destroyed)
-          container.destroyed(entity);
+        const auto entity = entity_destroy_queue.front();
+        entity_destroy_queue.pop();
+        if (entity_container.mark_destroyed(entity))
+          destroy_batch.push_back(entity);
       }
 
-      for (auto &[_, container] : component_containers)
+      for (const auto &system : destroyed_systems)
       {
-        if (container.valid)
-          container.remove(entity);
+        for (const auto entity : destroy_batch)
+        {
+          if (entity_container.components(entity) & system.mask)
+            system.function(system.manager, entity);
+        }
       }
 
-      entity_container.remove(entity);
-      entity_destroy_queue.pop();
+      // Each type removes the components of all its entities in the batch at once
+      for (const auto &system : remove_systems)
+      {
+        type_batch.clear();
+        for (const auto entity : destroy_batch)
+        {
+          if (entity_container.components(entity) & system.mask)
+            type_batch.push_back(entity);
+        }
+
+        if (!type_batch.empty())
+          system.function(system.manager, type_batch);
+      }
+
+      for (const auto entity : destroy_batch)
+        entity_container.remove(entity);
     }
   }
 
+  // Moves the components of all non-persistent entities into a snapshot, the entities stop existing until the
+  // snapshot is restored. Entities waiting for destruction are destroyed first.
+  [[nodiscard]] Snapshot take_non_persistent_entities();
+  void restore_entities(Snapshot &&snapshot);
+
   void call_render(int until_depth = NEG_INF_DEPTH)
   {
-    for (auto &component_id : render_components)
+    if (systems_dirty)
+      build_systems();
+
+    render_stats.culled_count = 0;
+
+    const auto &render_systems = systems[Phase::Render];
+    for (size_t i = 0; i < render_systems.size(); i++)
     {
-      auto &container = component_containers[component_id];
-      if (container.render)
-        container.render();
+      render_material = static_cast<uint8_t>(std::min<size_t>(i, std::numeric_limits<uint8_t>::max()));
+      render_systems[i].function(render_systems[i].manager);
     }
 
-    // Farther objects have higher depth values
-    std::stable_sort(std::begin(draw_calls),
-                     std::end(draw_calls),
-                     [](const DrawCall &a, const DrawCall &b) { return a.depth > b.depth; });
+    render_stats.visible_count = render_commands.size();
+
+    sort_render_commands();
 
     size_t start_index = last_draw_call_index;
-    if (start_index >= draw_calls.size() - 1)
+    if (start_index >= render_commands.size() - 1)
       start_index = 0;
 
-    for (size_t i = start_index; i < draw_calls.size(); i++)
+    for (size_t i = start_index; i < render_commands.size(); i++)
     {
       last_draw_call_index = i;
 
-      const auto &draw_call = draw_calls[i];
+      const auto &command = render_commands[i];
 
-      if (draw_call.depth < until_depth)
+      if (command.depth() < until_depth)
         break;
 
-      draw_call.render();
+      command.draw(command.component);
     }
     if (until_depth == NEG_INF_DEPTH)
       last_draw_call_index = std::numeric_limits<size_t>::max();
 
-    draw_calls.clear();
+    render_commands.clear();
+  }
+
+  [[nodiscard]] inline const RenderStats &get_render_stats() const
+  {
+    return render_stats;
+  }
+
+  inline void set_render_view(float x, float y, float width, float height, float margin)
+  {
+    render_view = RenderView{ x - margin, y - margin, x + width + margin, y + height + margin, true };
+  }
+
+  inline void clear_render_view()
+  {
+    render_view = RenderView{};
+  }
+
+  [[nodiscard]] inline const RenderView &get_render_view() const
+  {
+    return render_view;
   }
 
 private:
@@ -460,12 +1282,15 @@ private:
     component.entity        = entity;
     auto &component_manager = *static_cast<ComponentManager<C> *>(container.manager);
 
+#if !defined(PACKED_COMPONENTS)
     assert(component_manager.count() < MAX_COMPONENTS_PER_TYPE && "Component count exceeded");
+#endif
 
     if constexpr (has_init<C>)
       has_new_init = true;
 
     component_manager.push(entity, std::move(component));
+    entity_container.add_components(entity, container.mask);
     return ComponentReference<C>{ component_manager.get_reference_index(component_manager.count() - 1) };
   }
 
@@ -478,7 +1303,8 @@ private:
     assert(container.valid && "Component manager does not exist");
 
     if (container.remove)
-      container.remove(entity);
+      container.remove(container.manager, entity);
+    entity_container.remove_components(entity, container.mask);
   }
 
   template<typename C>
@@ -490,12 +1316,8 @@ private:
 
     auto &component_manager = *static_cast<ComponentManager<C> *>(container.manager);
     std::set<C *> components;
-    for (size_t i = 0; i < component_manager.components_count; i++)
-    {
-      const auto &component = component_manager.components[i];
-      if (component.entity == entity)
-        components.insert(&component.component);
-    }
+    for (auto i = component_manager.first_of(entity); i != INVALID_INDEX; i = component_manager.next_of(i))
+      components.insert(&component_manager.get(i));
 
     return components;
   }
@@ -508,19 +1330,23 @@ private:
     assert(container.valid && "Component manager does not exist");
 
     auto &component_manager = *static_cast<ComponentManager<C> *>(container.manager);
-    for (size_t i = 0; i < component_manager.count(); i++)
-    {
-      auto &component = component_manager.get(i);
-      if (component.entity == entity)
-      {
-        const auto reference_index = component_manager.get_reference_index(i);
-        return ComponentReference<C>{ reference_index };
-      }
-    }
+    if (const auto i = component_manager.first_of(entity); i != INVALID_INDEX)
+      return ComponentReference<C>{ component_manager.get_reference_index(i) };
 
     return ComponentReference<C>{ INVALID_INDEX };
   }
 
+  template<typename... Cs>
+  [[nodiscard]] View<Cs...> view()
+  {
+    assert(created && "Manager not created");
+    assert((component_containers[Cs::id()].valid && ...) && "Component manager does not exist");
+
+    return View<Cs...>{ entity_container,
+                        (component_containers[Cs::id()].mask | ...),
+                        &component_containers[Cs::id()].template get_manager<Cs>()... };
+  }
+
   template<typename C>
   [[nodiscard]] ComponentsSpan<C> get_components()
   {
@@ -529,7 +1355,7 @@ private:
     assert(container.valid && "Component manager does not exist");
 
     auto &component_manager = *static_cast<ComponentManager<C> *>(container.manager);
-    return ComponentsSpan<C>{ component_manager.components.data(), component_manager.count() };
+    return ComponentsSpan<C>{ &component_manager.components, component_manager.count() };
   }
 
   inline void set_persistent(Entity entity)
@@ -552,22 +1378,43 @@ public:
   std::unordered_map<ComponentType, ComponentManagerContainer> component_containers;
 
   bool has_new_init{ false };
-  std::set<ComponentType> init_components;
-  std::set<ComponentType> preupdate_components;
-  std::set<ComponentType> update_components;
-  std::set<ComponentType> postupdate_components;
-  std::set<ComponentType> render_components;
-  std::set<ComponentType> collision_components;
-  std::set<ComponentType> destroyed_components;
+
+  bool systems_dirty{ true };
+  std::array<std::vector<System<SystemFunction>>, PhaseCount> systems;
+  std::array<std::vector<System<SystemFunction>>, PhaseCount> registered_systems;
+  std::vector<System<CollisionFunction>> collision_systems;
+  std::vector<System<EntityFunction>> destroyed_systems;
+  std::vector<System<EntitiesFunction>> remove_systems;
+
+  // Indices into systems grouped by stage, stage_ends holds the end of each group
+  std::array<std::vector<uint32_t>, PhaseCount> stage_systems;
+  std::array<std::vector<uint32_t>, PhaseCount> stage_ends;
+#if defined(SERIAL_SYSTEMS)
+  bool serial_systems{ true };
+#else
+  bool serial_systems{ false };
+#endif
 
   std::queue<Entity> entity_destroy_queue;
-  std::vector<DrawCall> draw_calls;
+  // Reused by call_destroy
+  std::vector<Entity> destroy_batch;
+  std::vector<Entity> type_batch;
+  size_t component_type_count{ 0 };
+  // Reused across frames, the capacity only grows
+  std::vector<RenderCommand> render_commands;
+  std::vector<RenderCommand> render_commands_scratch;
   std::set<Entity> persistent_entities;
 
 private:
   bool created{ true };
   EntityContainer entity_container;
   size_t last_draw_call_index{ std::numeric_limits<size_t>::max() };
+  uint8_t render_material{ 0 };
+  RenderStats render_stats;
+  RenderView render_view;
+
+  // Stable LSD radix sort on the command keys, bytes shared by every key are skipped
+  void sort_render_commands();
 
   template<typename C>
   friend ComponentReference<C> add_component(Entity, C &&);
@@ -578,6 +1425,9 @@ private:
   template<typename C>
   friend ComponentsSpan<C> get_components();
 
+  template<typename... Cs>
+  friend View<Cs...> view();
+
   template<typename C>
   friend std::set<C *> get_components(Entity);
 
@@ -594,10 +1444,13 @@ private:
   friend void destroy_non_persistent_entities();
 
   friend bool entity_exists(Entity);
+  friend size_t entity_count();
 
   template<typename C>
   friend struct RegisterComponent;
 
+  friend struct RegisterSystem;
+
   friend void set_persistent(Entity);
   friend void unset_persistent(Entity);
   friend bool is_persistent(Entity);
@@ -621,6 +1474,12 @@ template<typename C>
   return Manager::get().get_components<C>();
 }
 
+template<typename... Cs>
+[[nodiscard]] inline Manager::View<Cs...> view()
+{
+  return Manager::get().view<Cs...>();
+}
+
 template<typename C>
 [[nodiscard]] inline std::set<C *> get_components(Entity entity)
 {
@@ -670,6 +1529,11 @@ inline void destroy_non_persistent_entities()
   return Manager::get().entity_exists(entity);
 }
 
+[[nodiscard]] inline size_t entity_count()
+{
+  return Manager::get().entity_count();
+}
+
 [[nodiscard]] inline bool is_persistent(Entity entity)
 {
   return Manager::get().is_persistent(entity);
@@ -705,7 +1569,7 @@ struct ComponentReference
     assert(index != INVALID_INDEX && "Invalid component reference");
     auto &manager              = Manager::get().component_containers[C::id()].template get_manager<C>();
     const auto component_index = manager.get_component_index(index);
-    assert(component_index < manager.count());
+    assert(component_index < manager.count() && "Stale component reference");
     return manager.get(component_index);
   }
 
@@ -728,6 +1592,33 @@ struct RegisterComponent
   RegisterComponent &operator=(RegisterComponent &&)      = delete;
 };
 
+struct RegisterSystem
+{
+  inline RegisterSystem(Manager::Phase phase, Manager::SystemFunction function, int priority = 0)
+  {
+    Manager::get().register_system(phase, function, priority);
+  }
+
+  template<typename... Reads, typename... Writes>
+  inline RegisterSystem(Manager::Phase phase,
+                        Manager::SystemFunction function,
+                        int priority,
+                        ComponentTypes<Reads...>,
+                        ComponentTypes<Writes...>)
+  {
+    Manager::get().register_system(
+      phase,
+      function,
+      priority,
+      &Manager::system_access<ComponentTypes<Reads...>, ComponentTypes<Writes...>>);
+  }
+
+  RegisterSystem(const RegisterSystem &)            = delete;
+  RegisterSystem &operator=(const RegisterSystem &) = delete;
+  RegisterSystem(RegisterSystem &&)                 = delete;
+  RegisterSystem &operator=(RegisterSystem &&)      = delete;
+};
+
 #define COMPONENT(C)                         \
   static consteval ComponentType id()        \
   {                                          \
@@ -756,3 +1647,7 @@ struct RegisterComponent
 
 #define REGISTER_COMPONENT(C) \
   static inline RegisterComponent<C> register_component_##C {}
+
+// Optionally followed by ComponentTypes<...>{} the system reads and ComponentTypes<...>{} it writes
+#define REGISTER_SYSTEM(PHASE, FUNCTION, PRIORITY, ...) \
+  static inline RegisterSystem register_system_##FUNCTION { Manager::PHASE, &FUNCTION, PRIORITY __VA_OPT__(, ) __VA_ARGS__ }
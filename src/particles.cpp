@@ -1,5 +1,6 @@
 #include "particles.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 #include "utils.hpp"
@@ -221,6 +222,9 @@ void ParticleSystem::render()
 
   // TODO: implement interpolation
 
+  // Particles are spread over the whole level, so they are culled one by one
+  const auto &view = Manager::get().get_render_view();
+
   for (const auto &particle : particles)
   {
     const float alpha = roundf(particle.alpha * 4.0f) / 4.0f;
@@ -229,6 +233,10 @@ void ParticleSystem::render()
       assert(particle.sprite_id < sprites.size());
       auto &sprite = sprites[particle.sprite_id];
 
+      const float extent = std::max(sprite.get_width(), sprite.get_height()) * fabsf(particle.size);
+      if (!view.overlaps(particle.x - extent, particle.y - extent, extent * 2.0f, extent * 2.0f))
+        continue;
+
       const int frame = static_cast<int>(roundf(particle.frame));
 
       if (frame < 0 || frame >= sprite.get_frame_count())
@@ -244,6 +252,10 @@ void ParticleSystem::render()
     }
     else
     {
+      const float extent = particle.size;
+      if (!view.overlaps(particle.x - extent, particle.y - extent, extent * 2.0f, extent * 2.0f))
+        continue;
+
       if (particle.size > 1.0f)
       {
         DrawCircle(particle.x, particle.y, particle.size, ColorAlpha(particle.color, alpha));
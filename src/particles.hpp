@@ -85,6 +85,9 @@ struct ParticleSystem
 {
   COMPONENT(ParticleSystem);
 
+  // Only touches its own particles, emitters add them from other systems
+  using writes = ComponentTypes<>;
+
   ParticleSystem(int depth)
     : depth(depth)
   {
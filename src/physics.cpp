@@ -11,19 +11,70 @@ COMPONENT_TEMPLATE(Physics);
 // TODO: Implement DEBUG_PROFILE_MASK_CHECK
 #define DEBUG_PROFILE_MASK_CHECK(name, mask, offset_x, offset_y)
 
-void for_physics_components(std::function<void(Physics &)> &&func)
+// Visits bodies stored in grid cells overlapping the given cells, in component order
+template<typename F>
+static void for_physics_components_near(const PhysicsGrid::Cells &cells, F &&func)
 {
-  auto physics_components = get_components<Physics>();
-  for (auto &component : physics_components)
+  auto &grid       = PhysicsGrid::get();
+  auto &candidates = grid.acquire_buffer();
+  grid.query(cells, candidates);
+
+  for (auto *physics : candidates)
+    func(*physics);
+
+  grid.release_buffer();
+}
+
+// Returns true as soon as the predicate matches one of the nearby bodies
+template<typename F>
+[[nodiscard]] static bool any_physics_component_near(const PhysicsGrid::Cells &cells, F &&predicate)
+{
+  auto &grid       = PhysicsGrid::get();
+  auto &candidates = grid.acquire_buffer();
+  grid.query(cells, candidates);
+
+  bool found = false;
+  for (auto *physics : candidates)
   {
-    func(component);
+    if (predicate(*physics))
+    {
+      found = true;
+      break;
+    }
   }
+
+  grid.release_buffer();
+  return found;
+}
+
+void Physics::init()
+{
+  PhysicsGrid::get().add(*this);
+}
+
+void Physics::destroyed()
+{
+  PhysicsGrid::get().remove(*this);
+}
+
+// Cached rooms take their bodies out of the grid, the reference index changes when they are restored
+void Physics::stored()
+{
+  PhysicsGrid::get().remove(*this);
+}
+
+void Physics::restored()
+{
+  PhysicsGrid::get().add(*this);
 }
 
 void Physics::update()
 {
   bool ignore_physics = solid && !collidable && !movable;
 
+  // Position may have been set directly since the last tick
+  PhysicsGrid::get().update(*this);
+
   if (!ignore_physics)
   {
     update_previous();
@@ -52,7 +103,10 @@ void Physics::check_collisions()
 
   auto &manager = Manager::get();
 
-  auto func = [this, &manager](Physics &other) -> void
+  const auto collision_vx = static_cast<int>(roundf(v.x + v_rem.x));
+  const auto collision_vy = static_cast<int>(roundf(v.y + v_rem.y));
+
+  auto func = [this, &manager, collision_vx, collision_vy](Physics &other) -> void
   {
     if (&other == this)
       return;
@@ -66,19 +120,15 @@ void Physics::check_collisions()
     if (!other.collidable)
       return;
 
-    auto vx = static_cast<int>(roundf(v.x + v_rem.x));
-    auto vy = static_cast<int>(roundf(v.y + v_rem.y));
-    if (is_colliding(other, vx, vy))
-    {
-      for (const auto &component_id : manager.collision_components)
-      {
-        const auto &container = manager.component_containers[component_id];
-        container.collision(entity, other.entity);
-      }
-    }
+    if (is_colliding(other, collision_vx, collision_vy))
+      manager.call_collision(entity, other.entity);
   };
 
-  for_physics_components(func);
+  const auto tile_entity = TileCollision::get().entity;
+  if (!solid && movable && tile_entity != INVALID_ENTITY && is_colliding_with_tiles(collision_vx, collision_vy))
+    manager.call_collision(entity, tile_entity);
+
+  for_physics_components_near(grid_cells_at(collision_vx, collision_vy), func);
 
   const auto vx = static_cast<int>(floorf(v.x));
   const auto vy = static_cast<int>(floorf(v.y));
@@ -126,8 +176,7 @@ bool Physics::is_colliding_with_any(int offset_x, int offset_y) const
 {
   DEBUG_PROFILE_MASK_CHECK("any", mask, x + offset_x, y + offset_y);
 
-  bool found = false;
-  auto check = [this, &found, offset_x, offset_y](Physics &other)
+  auto check = [this, offset_x, offset_y](Physics &other)
   {
     if (&other == this)
       return false;
@@ -135,26 +184,20 @@ bool Physics::is_colliding_with_any(int offset_x, int offset_y) const
     if (!other.collidable)
       return false;
 
-    if (is_colliding(other, offset_x, offset_y))
-    {
-      found = true;
-      return true;
-    }
-
-    return false;
+    return is_colliding(other, offset_x, offset_y);
   };
 
-  for_physics_components(check);
+  if (is_colliding_with_tiles(offset_x, offset_y))
+    return true;
 
-  return found;
+  return any_physics_component_near(grid_cells_at(offset_x, offset_y), check);
 }
 
 bool Physics::is_colliding_with_nonsolid(int offset_x, int offset_y) const
 {
   DEBUG_PROFILE_MASK_CHECK("nonsolid", mask, x + offset_x, y + offset_y);
 
-  bool found = false;
-  auto func  = [this, &found, offset_x, offset_y](Physics &other)
+  auto func = [this, offset_x, offset_y](Physics &other)
   {
     if (&other == this)
       return false;
@@ -165,26 +208,17 @@ bool Physics::is_colliding_with_nonsolid(int offset_x, int offset_y) const
     if (other.solid)
       return false;
 
-    if (is_colliding(other, offset_x, offset_y))
-    {
-      found = true;
-      return true;
-    }
-
-    return false;
+    return is_colliding(other, offset_x, offset_y);
   };
 
-  for_physics_components(func);
-
-  return found;
+  return any_physics_component_near(grid_cells_at(offset_x, offset_y), func);
 }
 
 bool Physics::is_colliding_with_solid(int offset_x, int offset_y) const
 {
   DEBUG_PROFILE_MASK_CHECK("solid", mask, x + offset_x, y + offset_y);
 
-  bool found = false;
-  auto func  = [this, &found, offset_x, offset_y](Physics &other)
+  auto func = [this, offset_x, offset_y](Physics &other)
   {
     if (&other == this)
       return false;
@@ -198,18 +232,13 @@ bool Physics::is_colliding_with_solid(int offset_x, int offset_y) const
     if (other.oneway && mask.bottom(y) > other.mask.top(other.y))
       return false;
 
-    if (is_colliding(other, offset_x, offset_y))
-    {
-      found = true;
-      return true;
-    }
-
-    return false;
+    return is_colliding(other, offset_x, offset_y);
   };
 
-  for_physics_components(func);
+  if (is_colliding_with_tiles(offset_x, offset_y, static_cast<int>(mask.bottom(y))))
+    return true;
 
-  return found;
+  return any_physics_component_near(grid_cells_at(offset_x, offset_y), func);
 }
 
 bool Physics::is_standing() const
@@ -256,7 +285,10 @@ EntitySet Physics::get_colliding_solid(int offset_x, int offset_y) const
     }
   };
 
-  for_physics_components(func);
+  if (is_colliding_with_tiles(offset_x, offset_y, static_cast<int>(mask.bottom(y))))
+    colliding_entities.insert(TileCollision::get().entity);
+
+  for_physics_components_near(grid_cells_at(offset_x, offset_y), func);
 
   return colliding_entities;
 }
@@ -285,7 +317,7 @@ EntitySet Physics::get_colliding_nonsolid(int offset_x, int offset_y) const
       colliding_entities.insert(other.entity);
   };
 
-  for_physics_components(func);
+  for_physics_components_near(grid_cells_at(offset_x, offset_y), func);
 
   return colliding_entities;
 }
@@ -308,7 +340,10 @@ EntitySet Physics::get_colliding_any(int offset_x, int offset_y) const
       colliding_entities.insert(other.entity);
   };
 
-  for_physics_components(func);
+  if (is_colliding_with_tiles(offset_x, offset_y))
+    colliding_entities.insert(TileCollision::get().entity);
+
+  for_physics_components_near(grid_cells_at(offset_x, offset_y), func);
 
   return colliding_entities;
 }
@@ -350,6 +385,7 @@ void Physics::move_xy(float vec_x, float vec_y)
 
       x += sign;
       move_x -= sign;
+      PhysicsGrid::get().update(*this);
 
       if (solid)
       {
@@ -400,6 +436,7 @@ void Physics::move_xy(float vec_x, float vec_y)
 
       y += sign;
       move_y -= sign;
+      PhysicsGrid::get().update(*this);
 
       if (solid)
       {
@@ -463,7 +500,7 @@ std::set<Physics *> Physics::get_riding() const
     return false;
   };
 
-  for_physics_components(func);
+  for_physics_components_near(grid_cells_at(0, -1), func);
 
   return riding_components;
 }
@@ -498,7 +535,7 @@ std::set<Physics *> Physics::get_pushable() const
     return true;
   };
 
-  for_physics_components(func);
+  for_physics_components_near(grid_cells_at(0, 0), func);
 
   return colliding_entities;
 }
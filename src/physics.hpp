@@ -10,12 +10,18 @@
 #include "manager.hpp"
 
 #include "mask.hpp"
+#include "physics_grid.hpp"
+#include "tile_collision.hpp"
 
 struct Physics
 {
   COMPONENT(Physics);
 
+  void init();
   void update();
+  void destroyed();
+  void stored();
+  void restored();
 
 #if defined(DEBUG)
   void render()
@@ -23,6 +29,11 @@ struct Physics
     if (IsKeyDown(KEY_F1))
       mask.draw(x, y);
   }
+
+  [[nodiscard]] inline Rectangle render_bounds() const
+  {
+    return mask.rect(x, y);
+  }
 #endif
 
   int x_previous{ 0 };
@@ -85,6 +96,29 @@ private:
 
   void move_xy(float vec_x, float vec_y);
 
+  [[nodiscard]] inline PhysicsGrid::Cells grid_cells_at(int offset_x, int offset_y) const
+  {
+    return PhysicsGrid::cells_of(
+      x + offset_x - mask.origin_x, y + offset_y - mask.origin_y, mask.width, mask.height);
+  }
+
+  [[nodiscard]] inline bool is_colliding_with_tiles(int offset_x,
+                                                    int offset_y,
+                                                    int bottom = TileCollision::NO_ONEWAY_LIMIT) const
+  {
+    if (mask.width == 0 || mask.height == 0)
+      return false;
+
+    return TileCollision::get().is_solid(
+      x + offset_x - mask.origin_x, y + offset_y - mask.origin_y, mask.width, mask.height, bottom);
+  }
+
+  ReferenceIndex grid_reference{ INVALID_INDEX };
+  PhysicsGrid::Cells grid_cells;
+  uint32_t grid_stamp{ 0 };
+
+  friend struct PhysicsGrid;
+
   [[nodiscard]] inline bool is_colliding(const Physics &other, int offset_x, int offset_y) const
   {
     if (mask.width == 0 || mask.height == 0)
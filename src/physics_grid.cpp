@@ -0,0 +1,216 @@
+#include "physics_grid.hpp"
+
+#include <algorithm>
+
+#include "manager.hpp"
+#include "physics.hpp"
+
+[[nodiscard]] static inline Manager::ComponentManager<Physics> &physics_manager()
+{
+  return Manager::get().component_containers[Physics::id()].get_manager<Physics>();
+}
+
+PhysicsGrid &PhysicsGrid::get()
+{
+  static PhysicsGrid instance;
+  return instance;
+}
+
+void PhysicsGrid::add(Physics &physics)
+{
+  physics.grid_reference = INVALID_INDEX;
+  has_new_bodies         = true;
+}
+
+void PhysicsGrid::remove(Physics &physics)
+{
+  if (built && physics.grid_reference != INVALID_INDEX)
+    erase(physics.grid_reference, physics.grid_cells);
+
+  physics.grid_reference = INVALID_INDEX;
+}
+
+void PhysicsGrid::update(Physics &physics)
+{
+  if (!built || physics.grid_reference == INVALID_INDEX)
+    return;
+
+  const auto new_cells = physics.grid_cells_at(0, 0);
+  if (new_cells == physics.grid_cells)
+    return;
+
+  erase(physics.grid_reference, physics.grid_cells);
+  insert(physics.grid_reference, new_cells);
+  physics.grid_cells = new_cells;
+}
+
+void PhysicsGrid::clear()
+{
+  cells.clear();
+  built          = false;
+  has_new_bodies = false;
+  synced_count   = 0;
+}
+
+void PhysicsGrid::query(const Cells &query_cells, std::vector<Physics *> &result)
+{
+  result.clear();
+
+  if (query_cells.empty())
+    return;
+
+  sync();
+
+  query_stamp += 1;
+  if (query_stamp == 0)
+  {
+    for (auto &physics : get_components<Physics>())
+      physics.grid_stamp = 0;
+    query_stamp = 1;
+  }
+
+  auto &manager = physics_manager();
+  candidates.clear();
+
+  for (int cell_y = query_cells.y0; cell_y <= query_cells.y1; cell_y++)
+  {
+    for (int cell_x = query_cells.x0; cell_x <= query_cells.x1; cell_x++)
+    {
+      auto it = cells.find(cell_key(cell_x, cell_y));
+      if (it == cells.end())
+        continue;
+
+      auto &references = it->second;
+      for (size_t i = 0; i < references.size();)
+      {
+        const auto component_index = manager.get_component_index(references[i]);
+        if (component_index == INVALID_INDEX)
+        {
+          // Component was removed without being destroyed
+          references[i] = references.back();
+          references.pop_back();
+          continue;
+        }
+        i++;
+
+        auto &physics = manager.get(component_index);
+        if (physics.grid_stamp == query_stamp)
+          continue;
+
+        physics.grid_stamp = query_stamp;
+        candidates.emplace_back(component_index, &physics);
+      }
+    }
+  }
+
+  // Keep the same visiting order as a linear scan over the components
+  std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+  result.reserve(candidates.size());
+  for (const auto &[_, physics] : candidates)
+    result.push_back(physics);
+}
+
+std::vector<Physics *> &PhysicsGrid::acquire_buffer()
+{
+  if (buffers_used >= buffers.size())
+    buffers.emplace_back();
+
+  return buffers[buffers_used++];
+}
+
+void PhysicsGrid::release_buffer()
+{
+  assert(buffers_used > 0 && "Physics grid buffer released twice");
+  buffers_used -= 1;
+}
+
+size_t PhysicsGrid::cell_count() const
+{
+  return cells.size();
+}
+
+size_t PhysicsGrid::entry_count() const
+{
+  size_t count = 0;
+  for (const auto &[_, references] : cells)
+    count += references.size();
+
+  return count;
+}
+
+void PhysicsGrid::sync()
+{
+  if (!built)
+  {
+    rebuild();
+    return;
+  }
+
+  // Bodies added since the last query are not initialized yet, but are already visible to a linear scan
+  auto &manager = physics_manager();
+  if (!has_new_bodies && manager.count() == synced_count)
+    return;
+
+  has_new_bodies = false;
+  synced_count   = manager.count();
+
+  for (size_t i = 0; i < manager.count(); i++)
+  {
+    auto &physics = manager.get(i);
+    if (physics.grid_reference != INVALID_INDEX)
+      continue;
+
+    physics.grid_reference = manager.get_reference_index(i);
+    physics.grid_cells     = physics.grid_cells_at(0, 0);
+    insert(physics.grid_reference, physics.grid_cells);
+  }
+}
+
+void PhysicsGrid::rebuild()
+{
+  for (auto &[_, references] : cells)
+    references.clear();
+
+  // References stored in components may be stale after a hot reload, so every body is reinserted
+  auto &manager = physics_manager();
+  for (size_t i = 0; i < manager.count(); i++)
+  {
+    auto &physics          = manager.get(i);
+    physics.grid_reference = manager.get_reference_index(i);
+    physics.grid_cells     = physics.grid_cells_at(0, 0);
+    insert(physics.grid_reference, physics.grid_cells);
+  }
+
+  built          = true;
+  has_new_bodies = false;
+  synced_count   = manager.count();
+}
+
+void PhysicsGrid::insert(ReferenceIndex reference, const Cells &body_cells)
+{
+  for (int cell_y = body_cells.y0; cell_y <= body_cells.y1; cell_y++)
+    for (int cell_x = body_cells.x0; cell_x <= body_cells.x1; cell_x++)
+      cells[cell_key(cell_x, cell_y)].push_back(reference);
+}
+
+void PhysicsGrid::erase(ReferenceIndex reference, const Cells &body_cells)
+{
+  for (int cell_y = body_cells.y0; cell_y <= body_cells.y1; cell_y++)
+  {
+    for (int cell_x = body_cells.x0; cell_x <= body_cells.x1; cell_x++)
+    {
+      auto it = cells.find(cell_key(cell_x, cell_y));
+      if (it == cells.end())
+        continue;
+
+      auto &references = it->second;
+      auto ref_it      = std::find(references.begin(), references.end(), reference);
+      if (ref_it != references.end())
+      {
+        *ref_it = references.back();
+        references.pop_back();
+      }
+    }
+  }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "manager.hpp"
+
+struct Physics;
+
+// Uniform grid broadphase. Every Physics body is stored in the cells its mask covers,
+// so collision queries only have to test the few bodies around the queried rectangle.
+struct PhysicsGrid
+{
+  static constexpr int CELL_SHIFT = 4;
+  static constexpr int CELL_SIZE  = 1 << CELL_SHIFT;
+
+  struct Cells
+  {
+    int x0{ 0 };
+    int y0{ 0 };
+    int x1{ -1 };
+    int y1{ -1 };
+
+    [[nodiscard]] inline bool empty() const
+    {
+      return x1 < x0 || y1 < y0;
+    }
+
+    bool operator==(const Cells &) const = default;
+  };
+
+  [[nodiscard]] static PhysicsGrid &get();
+
+  [[nodiscard]] static inline Cells cells_of(int left, int top, int width, int height)
+  {
+    width  = std::max(width, 1);
+    height = std::max(height, 1);
+    return { left >> CELL_SHIFT, top >> CELL_SHIFT, (left + width - 1) >> CELL_SHIFT, (top + height - 1) >> CELL_SHIFT };
+  }
+
+  // New bodies are inserted lazily by the next query
+  void add(Physics &physics);
+  void remove(Physics &physics);
+  void update(Physics &physics);
+  void clear();
+
+  // Collects bodies stored in the given cells, sorted by component index
+  void query(const Cells &cells, std::vector<Physics *> &result);
+
+  [[nodiscard]] std::vector<Physics *> &acquire_buffer();
+  void release_buffer();
+
+  [[nodiscard]] size_t cell_count() const;
+  [[nodiscard]] size_t entry_count() const;
+
+private:
+  void sync();
+  void rebuild();
+  void insert(ReferenceIndex reference, const Cells &cells);
+  void erase(ReferenceIndex reference, const Cells &cells);
+
+  [[nodiscard]] static inline uint64_t cell_key(int cell_x, int cell_y)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cell_x)) << 32) | static_cast<uint32_t>(cell_y);
+  }
+
+  std::unordered_map<uint64_t, std::vector<ReferenceIndex>> cells;
+  std::vector<std::pair<size_t, Physics *>> candidates;
+  std::deque<std::vector<Physics *>> buffers;
+  size_t buffers_used{ 0 };
+  size_t synced_count{ 0 };
+  uint32_t query_stamp{ 0 };
+  bool built{ false };
+  bool has_new_bodies{ false };
+};
@@ -0,0 +1,126 @@
+#include "profiler.hpp"
+
+#include <cstring>
+
+#include "magic_enum.hpp"
+
+Profiler &Profiler::get()
+{
+  static Profiler instance;
+  return instance;
+}
+
+size_t Profiler::section(const char *name)
+{
+  for (size_t i = 0; i < sections.size(); i++)
+  {
+    if (std::strcmp(sections[i].name, name) == 0)
+      return i;
+  }
+
+  sections.push_back(Section{ name });
+  return sections.size() - 1;
+}
+
+void Profiler::reset()
+{
+  for (auto &entry : sections)
+  {
+    entry.total = 0.0;
+    entry.max   = 0.0;
+    entry.calls = 0;
+  }
+}
+
+void Profiler::print(FILE *file, size_t ticks) const
+{
+  fprintf(file, "%-16s %-10s %-12s %-12s %-12s\n", "section", "calls", "total ms", "us/tick", "max us");
+
+  for (const auto &entry : sections)
+  {
+    if (entry.calls == 0)
+      continue;
+
+    fprintf(file,
+            "%-16s %-10zu %-12.3f %-12.3f %-12.3f\n",
+            entry.name,
+            entry.calls,
+            entry.total * 1e3,
+            ticks > 0 ? entry.total * 1e6 / ticks : 0.0,
+            entry.max * 1e6);
+  }
+}
+
+LoadProfiler &LoadProfiler::get()
+{
+  static LoadProfiler instance;
+  return instance;
+}
+
+const char *LoadProfiler::phase_name(Phase phase)
+{
+  return magic_enum::enum_name(phase).data();
+}
+
+void LoadProfiler::begin(const std::string &level)
+{
+  report       = Report{};
+  report.level = level;
+  start        = Profiler::Clock::now();
+}
+
+void LoadProfiler::end(const char *source)
+{
+  const std::chrono::duration<double> elapsed = Profiler::Clock::now() - start;
+  report.source                               = source;
+  report.total                                = elapsed.count();
+
+  if (print_reports)
+  {
+    printf("Load %s (%s): %.3f ms\n", report.level.c_str(), report.source, report.total * 1e3);
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+      if (report.phases[phase] > 0.0)
+        printf("  %-12s %.3f ms\n", phase_name(static_cast<Phase>(phase)), report.phases[phase] * 1e3);
+    }
+  }
+
+  if (csv)
+  {
+    fprintf(csv, "%s,%s", report.level.c_str(), report.source);
+    for (const auto seconds : report.phases)
+      fprintf(csv, ",%.6f", seconds * 1e3);
+    fprintf(csv, ",%.6f\n", report.total * 1e3);
+    fflush(csv);
+  }
+}
+
+bool LoadProfiler::open_csv(const char *path)
+{
+  close_csv();
+
+  csv = fopen(path, "a");
+  if (!csv)
+  {
+    fprintf(stderr, "Cannot open load profile %s\n", path);
+    return false;
+  }
+
+  fseek(csv, 0, SEEK_END);
+  if (ftell(csv) == 0)
+  {
+    fprintf(csv, "level,source");
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++)
+      fprintf(csv, ",%s ms", phase_name(static_cast<Phase>(phase)));
+    fprintf(csv, ",total ms\n");
+  }
+
+  return true;
+}
+
+void LoadProfiler::close_csv()
+{
+  if (csv)
+    fclose(csv);
+  csv = nullptr;
+}
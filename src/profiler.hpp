@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Accumulated wall time of named code sections. Sections are registered once and timed with ScopedTimer,
+// the PROFILE_SCOPE macro compiles to nothing outside of headless builds.
+struct Profiler
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Section
+  {
+    const char *name{ nullptr };
+    double total{ 0.0 };
+    double max{ 0.0 };
+    size_t calls{ 0 };
+  };
+
+  [[nodiscard]] static Profiler &get();
+
+  [[nodiscard]] size_t section(const char *name);
+
+  inline void add(size_t index, double seconds)
+  {
+    auto &entry = sections[index];
+    entry.total += seconds;
+    entry.calls += 1;
+    if (seconds > entry.max)
+      entry.max = seconds;
+  }
+
+  void reset();
+
+  // Prints total and per tick time of every section that was entered
+  void print(FILE *file, size_t ticks) const;
+
+  std::vector<Section> sections;
+};
+
+struct ScopedTimer
+{
+  explicit ScopedTimer(size_t section)
+    : section{ section }
+    , start{ Profiler::Clock::now() }
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    const std::chrono::duration<double> elapsed = Profiler::Clock::now() - start;
+    Profiler::get().add(section, elapsed.count());
+  }
+
+  ScopedTimer(const ScopedTimer &)            = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  size_t section;
+  Profiler::Clock::time_point start;
+};
+
+// Wall time of the phases of a single level load. Unlike the Profiler it is active in every build, every load
+// prints a report and is appended to the CSV file when one is open.
+struct LoadProfiler
+{
+  enum Phase
+  {
+    Store,
+    Parse,
+    Prepare,
+    Destroy,
+    Restore,
+    Collision,
+    Tiles,
+    Entities,
+    References,
+    Construct,
+    Init,
+    PHASE_COUNT
+  };
+
+  struct Report
+  {
+    std::string level;
+    const char *source{ "" };
+    std::array<double, PHASE_COUNT> phases{};
+    double total{ 0.0 };
+  };
+
+  [[nodiscard]] static LoadProfiler &get();
+
+  [[nodiscard]] static const char *phase_name(Phase phase);
+
+  void begin(const std::string &level);
+
+  inline void add(Phase phase, double seconds)
+  {
+    report.phases[phase] += seconds;
+  }
+
+  void end(const char *source);
+
+  // Writes the header when the file is empty, returns false when it cannot be opened
+  bool open_csv(const char *path);
+  void close_csv();
+
+  // The last finished load
+  [[nodiscard]] inline const Report &get_report() const
+  {
+    return report;
+  }
+
+  bool print_reports{ true };
+
+private:
+  Report report;
+  Profiler::Clock::time_point start;
+  FILE *csv{ nullptr };
+};
+
+struct LoadTimer
+{
+  explicit LoadTimer(LoadProfiler::Phase phase)
+    : phase{ phase }
+    , start{ Profiler::Clock::now() }
+  {
+  }
+
+  ~LoadTimer()
+  {
+    const std::chrono::duration<double> elapsed = Profiler::Clock::now() - start;
+    LoadProfiler::get().add(phase, elapsed.count());
+  }
+
+  LoadTimer(const LoadTimer &)            = delete;
+  LoadTimer &operator=(const LoadTimer &) = delete;
+
+private:
+  LoadProfiler::Phase phase;
+  Profiler::Clock::time_point start;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b)      PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(HEADLESS)
+  #define PROFILE_SCOPE(name)                                                                      \
+    static const size_t PROFILE_CONCAT(profile_section_, __LINE__) = Profiler::get().section(name); \
+    const ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__){ PROFILE_CONCAT(profile_section_, __LINE__) }
+#else
+  #define PROFILE_SCOPE(name)
+#endif
@@ -1,15 +1,32 @@
 #include "renderers.hpp"
 
+#include <rlgl.h>
+
 #include "game.hpp"
 #include "manager.hpp"
+#include "physics.hpp"
 #include "sprite.hpp"
 #include "utils.hpp"
 
 REGISTER_COMPONENT(SpriteRenderer);
 REGISTER_COMPONENT(TileRenderer);
+REGISTER_COMPONENT(TileChunkRenderer);
 
 COMPONENT_TEMPLATE(SpriteRenderer);
 COMPONENT_TEMPLATE(TileRenderer);
+COMPONENT_TEMPLATE(TileChunkRenderer);
+
+static void follow_physics(void *)
+{
+  for (auto [physics, renderer] : view<Physics, SpriteRenderer>())
+  {
+    if (renderer.follow_physics)
+      renderer.set_position(physics.x, physics.y);
+  }
+}
+
+// Runs before the postupdate of components, so they see their renderers at the new position
+REGISTER_SYSTEM(Postupdate, follow_physics, 1, ComponentTypes<Physics>{}, ComponentTypes<SpriteRenderer>{});
 
 void SpriteInterpolated::render()
 {
@@ -85,3 +102,32 @@ inline void TileRenderer::render(Sprite &sprite, Rectangle source, Vector2 posit
                  0.0f,
                  FULLWHITE);
 }
+
+void TileChunkRenderer::render()
+{
+  if (!IsTextureValid(texture))
+    return;
+
+  // Additional samplers are shared by the whole batch, so the batch is flushed around the chunk normal map
+  const auto &shader         = Game::world_shader();
+  const auto normal_location = GetShaderLocation(shader, "texture1");
+
+  rlDrawRenderBatchActive();
+  SetShaderValueTexture(shader, normal_location, normal_texture);
+
+  DrawTexture(texture, x, y, FULLWHITE);
+
+  rlDrawRenderBatchActive();
+  SetShaderValueTexture(shader, normal_location, tileset_normal.get_texture());
+}
+
+void TileChunkRenderer::destroyed()
+{
+  if (IsTextureValid(texture))
+    UnloadTexture(texture);
+  if (IsTextureValid(normal_texture))
+    UnloadTexture(normal_texture);
+
+  texture        = {};
+  normal_texture = {};
+}
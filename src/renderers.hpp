@@ -22,6 +22,11 @@ struct SpriteInterpolated
 
   inline void render();
 
+  [[nodiscard]] inline Rectangle bounds() const
+  {
+    return sprite.get_bounds({ x, y });
+  }
+
   float x{ 0.0f };
   float y{ 0.0f };
   float previous_x{ std::numeric_limits<float>::quiet_NaN() };
@@ -35,6 +40,9 @@ struct SpriteRenderer final
 {
   COMPONENT(SpriteRenderer);
 
+  // Animation only touches the sprite of the renderer
+  using writes = ComponentTypes<>;
+
   SpriteRenderer(const std::string &path)
     : sprite_interpolated{ path }
   {
@@ -65,7 +73,19 @@ struct SpriteRenderer final
 
   void render();
 
+  [[nodiscard]] inline unsigned int render_texture() const
+  {
+    return sprite_interpolated.sprite.get_texture_id();
+  }
+
+  [[nodiscard]] inline Rectangle render_bounds() const
+  {
+    return sprite_interpolated.bounds();
+  }
+
   int depth{ 0 };
+  // Moved to the Physics position of the entity every frame
+  bool follow_physics{ false };
   SpriteInterpolated sprite_interpolated;
 };
 
@@ -123,6 +143,17 @@ struct TileRenderer
     return sprite.get_texture();
   }
 
+  [[nodiscard]] inline unsigned int render_texture() const
+  {
+    return sprite.get_texture_id();
+  }
+
+  // Tiles are drawn centered on their position
+  [[nodiscard]] inline Rectangle render_bounds() const
+  {
+    return { static_cast<float>(x - w / 2), static_cast<float>(y - h / 2), static_cast<float>(w), static_cast<float>(h) };
+  }
+
   int depth{ 0 };
 
   int32_t x{ 0 };
@@ -140,5 +171,61 @@ private:
   bool visible{ true };
 };
 
+// Static tiles of one layer baked into a texture at level load, drawn as a single quad.
+// The normal map is baked with the same layout, because the dither shader samples both with the same coordinates.
+struct TileChunkRenderer
+{
+  COMPONENT(TileChunkRenderer);
+
+  TileChunkRenderer(const std::string &normal_path,
+                    TilePosition pos,
+                    int depth,
+                    Texture2D texture,
+                    Texture2D normal_texture)
+    : depth{ depth }
+    , x{ pos.x }
+    , y{ pos.y }
+    , texture{ texture }
+    , normal_texture{ normal_texture }
+    , tileset_normal{ normal_path }
+  {
+  }
+
+  void render();
+  void destroyed();
+
+  [[nodiscard]] inline unsigned int render_texture() const
+  {
+    return texture.id;
+  }
+
+  [[nodiscard]] inline size_t memory_usage() const
+  {
+    return static_cast<size_t>(GetPixelDataSize(texture.width, texture.height, texture.format)) +
+           static_cast<size_t>(GetPixelDataSize(normal_texture.width, normal_texture.height, normal_texture.format));
+  }
+
+  [[nodiscard]] inline Rectangle render_bounds() const
+  {
+    return { static_cast<float>(x),
+             static_cast<float>(y),
+             static_cast<float>(texture.width),
+             static_cast<float>(texture.height) };
+  }
+
+  int depth{ 0 };
+
+  int32_t x{ 0 };
+  int32_t y{ 0 };
+
+private:
+  Texture2D texture{};
+  Texture2D normal_texture{};
+
+  // Normal map of the tileset, bound again after the chunk is drawn
+  Sprite tileset_normal;
+};
+
 EXTERN_COMPONENT_TEMPLATE(SpriteRenderer);
 EXTERN_COMPONENT_TEMPLATE(TileRenderer);
+EXTERN_COMPONENT_TEMPLATE(TileChunkRenderer);
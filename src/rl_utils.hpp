@@ -30,8 +30,10 @@ struct FragShader
   inline void load(std::string_view path)
   {
     this->path = path;
-    shader     = LoadShader(0, path.data());
+#if !defined(HEADLESS)
+    shader = LoadShader(0, path.data());
     assert(IsShaderValid(shader));
+#endif
   }
 
   inline bool valid() const
@@ -89,9 +91,11 @@ struct RenderTexture
   };
 
   [[nodiscard]] inline RenderTexture(int width, int height, Smooth smooth = Smooth::Yes)
-    : value{ LoadRenderTexture(width, height) }
+    : value{ load(width, height) }
   {
+#if !defined(HEADLESS)
     assert(valid() && "Failed to create render texture");
+#endif
 
     if (smooth == Smooth::Yes)
       apply_smooth();
@@ -116,9 +120,10 @@ struct RenderTexture
     height = std::max(1, height);
 
     UnloadRenderTexture(value);
-    value = LoadRenderTexture(width, height);
+    value = load(width, height);
 
-    SetTextureWrap(value.texture, TEXTURE_WRAP_CLAMP);
+    if (valid())
+      SetTextureWrap(value.texture, TEXTURE_WRAP_CLAMP);
 
     if (smooth == Smooth::Yes)
       apply_smooth();
@@ -127,7 +132,21 @@ struct RenderTexture
   inline void apply_smooth()
   {
     smooth = Smooth::Yes;
-    SetTextureFilter(value.texture, TEXTURE_FILTER_BILINEAR);
+    if (valid())
+      SetTextureFilter(value.texture, TEXTURE_FILTER_BILINEAR);
+  }
+
+  [[nodiscard]] static inline ::RenderTexture load(int width, int height)
+  {
+#if defined(HEADLESS)
+    // Nothing is drawn without a window, only the size is kept for camera and visibility checks
+    ::RenderTexture render_texture{};
+    render_texture.texture.width  = width;
+    render_texture.texture.height = height;
+    return render_texture;
+#else
+    return LoadRenderTexture(width, height);
+#endif
   }
 
   inline bool valid() const
@@ -0,0 +1,89 @@
+#include "room_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Level
+{
+size_t RoomCache::Room::memory_usage() const
+{
+  size_t memory = sizeof(Room) + snapshot.memory_usage;
+  memory += level_loader.tiles.capacity() * sizeof(Tile);
+  memory += level_loader.entities.size() * sizeof(EntityDef);
+  memory += static_cast<size_t>(tile_collision.columns) * static_cast<size_t>(tile_collision.rows);
+  return memory;
+}
+
+RoomCache &RoomCache::get()
+{
+  static RoomCache instance;
+  return instance;
+}
+
+void RoomCache::store(std::unique_ptr<Room> room)
+{
+  rooms.push_front(std::move(room));
+
+  size_t memory = memory_usage();
+  while (!rooms.empty() && memory > memory_budget)
+  {
+    const size_t room_memory = rooms.back()->memory_usage();
+    printf("Room cache: dropping %s (%.2f MB)\n",
+           rooms.back()->level_loader.name.c_str(),
+           room_memory / (1024.0 * 1024.0));
+
+    memory -= room_memory;
+    rooms.pop_back();
+  }
+}
+
+std::unique_ptr<RoomCache::Room> RoomCache::take(const LevelName &name, const LoadSettings &settings)
+{
+  const auto room_it = std::find_if(rooms.begin(),
+                                    rooms.end(),
+                                    [&](const auto &room)
+                                    { return room->level_loader.name == name && room->settings == settings; });
+  if (room_it == rooms.end())
+  {
+    misses += 1;
+    return nullptr;
+  }
+
+  hits += 1;
+  auto room = std::move(*room_it);
+  rooms.erase(room_it);
+  return room;
+}
+
+bool RoomCache::contains(const LevelName &name, const LoadSettings &settings) const
+{
+  return std::any_of(rooms.begin(),
+                     rooms.end(),
+                     [&](const auto &room) { return room->level_loader.name == name && room->settings == settings; });
+}
+
+void RoomCache::clear()
+{
+  rooms.clear();
+}
+
+size_t RoomCache::memory_usage() const
+{
+  size_t memory = 0;
+  for (const auto &room : rooms)
+    memory += room->memory_usage();
+  return memory;
+}
+
+void RoomCache::print_stats(FILE *file) const
+{
+  fprintf(file,
+          "Room cache: %zu rooms, %.2f / %.2f MB, %zu hits, %zu misses\n",
+          rooms.size(),
+          memory_usage() / (1024.0 * 1024.0),
+          memory_budget / (1024.0 * 1024.0),
+          hits,
+          misses);
+}
+
+} // namespace Level
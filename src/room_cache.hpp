@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdio>
+#include <list>
+#include <memory>
+
+#include "level.hpp"
+#include "level_loader.hpp"
+#include "manager.hpp"
+#include "tile_collision.hpp"
+
+namespace Level
+{
+// Recently left rooms with their constructed entities. Entering a cached room restores the entities as they were
+// left, instead of loading the level again and constructing every entity and component.
+struct RoomCache
+{
+  struct Room
+  {
+    LoadSettings settings;
+    LevelLoader level_loader;
+    TileCollision tile_collision;
+    Manager::Snapshot snapshot;
+
+    // Estimate of the level data, the collision map and the stored components
+    [[nodiscard]] size_t memory_usage() const;
+  };
+
+  [[nodiscard]] static RoomCache &get();
+
+  // Least recently left rooms are dropped while the cache is over its memory budget
+  void store(std::unique_ptr<Room> room);
+
+  // Removes the room from the cache, nullptr when it is not cached with the same settings
+  [[nodiscard]] std::unique_ptr<Room> take(const LevelName &name, const LoadSettings &settings);
+
+  [[nodiscard]] bool contains(const LevelName &name, const LoadSettings &settings) const;
+
+  void clear();
+
+  [[nodiscard]] size_t memory_usage() const;
+
+  [[nodiscard]] inline size_t size() const
+  {
+    return rooms.size();
+  }
+
+  void print_stats(FILE *file) const;
+
+  size_t memory_budget{ 32 * 1024 * 1024 };
+
+  size_t hits{ 0 };
+  size_t misses{ 0 };
+
+private:
+  // Most recently left room first
+  std::list<std::unique_ptr<Room>> rooms;
+};
+
+} // namespace Level
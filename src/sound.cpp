@@ -20,6 +20,8 @@ static std::unordered_map<std::string, std::vector<Sound>> SOUNDS;
 GameSound::GameSound(const std::string &file_path)
   : path{ file_path }
 {
+  // Headless builds have no audio device, sounds without loaded aliases are never played
+#if !defined(HEADLESS)
   Sound raw_sound;
 
   if (CachedSound::is_used(path))
@@ -28,6 +30,7 @@ GameSound::GameSound(const std::string &file_path)
     raw_sound = CachedSound::add(path, LoadSound(path.c_str()));
 
   SOUNDS[path].push_back(LoadSoundAlias(raw_sound));
+#endif
 }
 
 GameSound::~GameSound()
@@ -1,6 +1,7 @@
 #include "sprite.hpp"
 
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <filesystem>
@@ -100,6 +101,37 @@ inline void CachedTexture::destruct(CachedTexture *res)
 
 using CachedAse = struct CachedResource<ase_t *>;
 
+// Headless builds have no GL context, textures keep only their size
+[[nodiscard]] static Texture2D load_texture(const Image &image)
+{
+#if defined(HEADLESS)
+  return Texture2D{ 0, image.width, image.height, image.mipmaps, image.format };
+#else
+  return LoadTextureFromImage(image);
+#endif
+}
+
+[[nodiscard]] static Texture2D load_texture(const std::string &path)
+{
+#if defined(HEADLESS)
+  Image image             = LoadImage(path.c_str());
+  const Texture2D texture = load_texture(image);
+  UnloadImage(image);
+  return texture;
+#else
+  return LoadTexture(path.c_str());
+#endif
+}
+
+[[nodiscard]] static inline bool is_texture_loaded(const Texture2D &texture)
+{
+#if defined(HEADLESS)
+  return texture.width > 0 && texture.height > 0;
+#else
+  return IsTextureValid(texture);
+#endif
+}
+
 template<>
 inline void CachedAse::destruct(CachedAse *res)
 {
@@ -120,10 +152,10 @@ Sprite::Sprite(const std::string &file_path, std::string tag_name)
     if (CachedTexture::is_used(file_path))
       texture = CachedTexture::use(file_path);
     else
-      texture = CachedTexture::add(path, LoadTexture(std::string(path).c_str()));
+      texture = CachedTexture::add(path, load_texture(path));
   }
 
-  assert(IsTextureValid(texture));
+  assert(is_texture_loaded(texture));
 }
 
 Sprite::~Sprite()
@@ -174,7 +206,7 @@ void Sprite::load_texture_with_animation()
                               .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
       ImageDraw(&image, frameImage, src, dest, FULLWHITE);
     }
-    texture = CachedTexture::add(path, LoadTextureFromImage(image));
+    texture = CachedTexture::add(path, load_texture(image));
     UnloadImage(image);
   }
 
@@ -217,7 +249,7 @@ void Sprite::load_texture_with_animation()
 const Texture2D &Sprite::get_texture() const
 {
 #if defined(DEBUG)
-  assert(IsTextureValid(texture));
+  assert(is_texture_loaded(texture));
   if (IsKeyPressed(KEY_F7) && std::filesystem::exists(path) && !is_file_written(path))
   {
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -276,6 +308,24 @@ Rectangle Sprite::get_destination_rect() const
                     sprite_h * fabsf(scale.y) };
 }
 
+Rectangle Sprite::get_bounds(Vector2 at) const
+{
+  const float width  = static_cast<float>(get_width()) * fabsf(scale.x);
+  const float height = static_cast<float>(get_height()) * fabsf(scale.y);
+  const float x      = std::roundf(at.x + offset.x);
+  const float y      = std::roundf(at.y + offset.y);
+
+  if (rotation == 0.0f)
+    return Rectangle{ x - origin.x, y - origin.y, width, height };
+
+  // Rotation happens around the origin, so any corner can end up at the farthest distance from it
+  const float radius = std::max({ Vector2Length(origin),
+                                  Vector2Length({ width - origin.x, origin.y }),
+                                  Vector2Length({ origin.x, height - origin.y }),
+                                  Vector2Length({ width - origin.x, height - origin.y }) });
+  return Rectangle{ x - radius, y - radius, radius * 2.0f, radius * 2.0f };
+}
+
 void Sprite::draw() const noexcept
 {
   DrawTexturePro(get_texture(), get_source_rect(), get_destination_rect(), origin, rotation, tint);
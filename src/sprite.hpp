@@ -33,12 +33,19 @@ public:
   void draw() const noexcept;
 
   [[nodiscard]] const Texture2D &get_texture() const;
+  [[nodiscard]] inline unsigned int get_texture_id() const
+  {
+    return texture.id;
+  }
   [[nodiscard]] size_t get_width() const;
   [[nodiscard]] size_t get_height() const;
 
   [[nodiscard]] Rectangle get_source_rect() const;
   [[nodiscard]] Rectangle get_destination_rect() const;
 
+  // World rectangle covered when drawn at the given position, including origin and rotation
+  [[nodiscard]] Rectangle get_bounds(Vector2 at) const;
+
   void set_frame(int frame);
 
   // sets frame relative to tag start frame
@@ -15,6 +15,9 @@ REGISTER_COMPONENT(Terminal);
 COMPONENT_TEMPLATE(Terminal);
 REGISTER_LEVEL_ENTITY(Terminal);
 
+static const Level::FieldId TYPE_FIELD = Level::field_id("Type");
+static const Level::FieldId TEXT_FIELD = Level::field_id("Text");
+
 Terminal::Terminal(const Level::Entity &entity)
 {
   start_x = entity.position.x;
@@ -24,7 +27,7 @@ Terminal::Terminal(const Level::Entity &entity)
   h = entity.size.h;
 
   std::string type_str;
-  read_field(entity.fields, "Type", type_str);
+  read_field(entity.fields, TYPE_FIELD, type_str);
   auto type_val = magic_enum::enum_cast<Type>(type_str);
   if (type_val)
     type = type_val.value();
@@ -34,7 +37,7 @@ Terminal::Terminal(const Level::Entity &entity)
   }
 
   std::string text_str;
-  read_field(entity.fields, "Text", text_str);
+  read_field(entity.fields, TEXT_FIELD, text_str);
   messages = split(text_str, '\n');
 }
 
@@ -5,6 +5,10 @@
 #include "manager.hpp"
 #include "sound.hpp"
 
+struct Interactable;
+struct Light;
+struct SpriteRenderer;
+
 struct Terminal
 {
   enum Type
@@ -14,6 +18,9 @@ struct Terminal
   };
 
   COMPONENT(Terminal);
+
+  // Pulses the light of the terminal and disables it once it is used
+  using writes = ComponentTypes<Interactable, Light, SpriteRenderer>;
   Terminal(const Level::Entity &entity);
 
   void init();
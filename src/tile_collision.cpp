@@ -0,0 +1,131 @@
+#include "tile_collision.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+TileCollision &TileCollision::get()
+{
+  static TileCollision instance;
+  return instance;
+}
+
+void TileCollision::reset(int width, int height, int cell_size)
+{
+  assert(cell_size > 0 && "Invalid tile collision cell size");
+
+  this->cell_size = cell_size;
+  columns         = std::max(0, (width + cell_size - 1) / cell_size);
+  rows            = std::max(0, (height + cell_size - 1) / cell_size);
+
+  cells.assign(static_cast<size_t>(columns) * rows, None);
+}
+
+void TileCollision::clear()
+{
+  cells.clear();
+  columns = 0;
+  rows    = 0;
+  entity  = INVALID_ENTITY;
+}
+
+void TileCollision::set(int x, int y, int w, int h, uint8_t flags)
+{
+  if (w <= 0 || h <= 0)
+    return;
+
+  const int x0 = std::max(cell_of(x), 0);
+  const int y0 = std::max(cell_of(y), 0);
+  const int x1 = std::min(cell_of(x + w - 1), columns - 1);
+  const int y1 = std::min(cell_of(y + h - 1), rows - 1);
+
+  for (int cell_y = y0; cell_y <= y1; cell_y++)
+    for (int cell_x = x0; cell_x <= x1; cell_x++)
+      cells[cell_y * columns + cell_x] |= flags;
+}
+
+bool TileCollision::is_solid(int left, int top, int width, int height, int bottom) const
+{
+  if (cells.empty() || width <= 0 || height <= 0)
+    return false;
+
+  const int x0 = std::max(cell_of(left), 0);
+  const int y0 = std::max(cell_of(top), 0);
+  const int x1 = std::min(cell_of(left + width - 1), columns - 1);
+  const int y1 = std::min(cell_of(top + height - 1), rows - 1);
+
+  for (int cell_y = y0; cell_y <= y1; cell_y++)
+  {
+    const uint8_t *row = &cells[cell_y * columns];
+    for (int cell_x = x0; cell_x <= x1; cell_x++)
+    {
+      const uint8_t cell = row[cell_x];
+      if (!(cell & Solid))
+        continue;
+
+      if ((cell & OneWay) && bottom > cell_y * cell_size)
+        continue;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint8_t TileCollision::at(int cell_x, int cell_y) const
+{
+  if (cell_x < 0 || cell_y < 0 || cell_x >= columns || cell_y >= rows)
+    return None;
+
+  return cells[cell_y * columns + cell_x];
+}
+
+size_t TileCollision::solid_count() const
+{
+  return std::count_if(cells.begin(), cells.end(), [](uint8_t cell) { return cell & Solid; });
+}
+
+void TileCollision::for_each_rectangle(const std::function<void(int, int, int, int, uint8_t)> &callback) const
+{
+  std::vector<bool> merged(cells.size(), false);
+
+  const auto can_merge = [&](int cell_x, int cell_y, uint8_t flags)
+  {
+    const size_t index = cell_y * columns + cell_x;
+    return !merged[index] && cells[index] == flags;
+  };
+
+  for (int cell_y = 0; cell_y < rows; cell_y++)
+  {
+    for (int cell_x = 0; cell_x < columns; cell_x++)
+    {
+      const uint8_t flags = cells[cell_y * columns + cell_x];
+      if (!(flags & Solid) || merged[cell_y * columns + cell_x])
+        continue;
+
+      int width = 1;
+      while (cell_x + width < columns && can_merge(cell_x + width, cell_y, flags))
+        width++;
+
+      // Every row of one-way tiles is a platform of its own, so they are only merged horizontally
+      int height = 1;
+      while (!(flags & OneWay) && cell_y + height < rows)
+      {
+        bool row_matches = true;
+        for (int x = cell_x; x < cell_x + width && row_matches; x++)
+          row_matches = can_merge(x, cell_y + height, flags);
+
+        if (!row_matches)
+          break;
+
+        height++;
+      }
+
+      for (int y = cell_y; y < cell_y + height; y++)
+        for (int x = cell_x; x < cell_x + width; x++)
+          merged[y * columns + x] = true;
+
+      callback(cell_x * cell_size, cell_y * cell_size, width * cell_size, height * cell_size, flags);
+    }
+  }
+}
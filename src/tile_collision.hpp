@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "component.hpp"
+
+// Collision map of the static level tiles, one byte per grid cell.
+// Solid tiles are not created as separate Physics bodies, queries test the cells under a rectangle instead.
+struct TileCollision
+{
+  enum Flags : uint8_t
+  {
+    None   = 0,
+    Solid  = 1 << 0,
+    OneWay = 1 << 1,
+  };
+
+  static constexpr int NO_ONEWAY_LIMIT = std::numeric_limits<int>::min();
+
+  [[nodiscard]] static TileCollision &get();
+
+  void reset(int width, int height, int cell_size);
+  void clear();
+  void set(int x, int y, int w, int h, uint8_t flags);
+
+  // One-way cells only count when their top is not above the given bottom edge
+  [[nodiscard]] bool is_solid(int left, int top, int width, int height, int bottom = NO_ONEWAY_LIMIT) const;
+
+  [[nodiscard]] uint8_t at(int cell_x, int cell_y) const;
+  [[nodiscard]] size_t solid_count() const;
+
+  // Greedily merges cells with equal flags into maximal rectangles, reported in pixels
+  void for_each_rectangle(const std::function<void(int x, int y, int w, int h, uint8_t flags)> &callback) const;
+
+  [[nodiscard]] inline bool empty() const
+  {
+    return cells.empty();
+  }
+
+  // Entity reported to collision callbacks when a body hits a tile
+  Entity entity{ INVALID_ENTITY };
+
+  int cell_size{ 8 };
+  int columns{ 0 };
+  int rows{ 0 };
+
+private:
+  [[nodiscard]] inline int cell_of(int position) const
+  {
+    return position >= 0 ? position / cell_size : (position - cell_size + 1) / cell_size;
+  }
+
+  std::vector<uint8_t> cells;
+};
@@ -0,0 +1,33 @@
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+// The engine normally owns manager and game memory, so the benchmarks and the headless runner share these
+void *manager_memory{ nullptr };
+void *allocate_manager(size_t alignment, size_t size)
+{
+  if (!manager_memory)
+  {
+    manager_memory = std::aligned_alloc(alignment, size * 2);
+    assert(manager_memory);
+    std::align(alignment, size, manager_memory, size);
+    std::memset(manager_memory, 0, size);
+  }
+
+  return manager_memory;
+}
+
+void *game_memory{ nullptr };
+void *allocate_game(size_t alignment, size_t size)
+{
+  if (!game_memory)
+  {
+    game_memory = std::aligned_alloc(alignment, size * 2);
+    assert(game_memory);
+    std::align(alignment, size, game_memory, size);
+    std::memset(game_memory, 0, size);
+  }
+
+  return game_memory;
+}
@@ -0,0 +1,121 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+// The calling thread works on the batch too, so a few workers cover the systems that can run at the same time
+constexpr static size_t MAX_WORKERS = 7;
+
+WorkerPool &WorkerPool::get()
+{
+  static WorkerPool instance;
+  return instance;
+}
+
+WorkerPool::~WorkerPool()
+{
+  stop();
+}
+
+void WorkerPool::run(Job batch_job, void *batch_context, size_t batch_count)
+{
+  if (batch_count == 0)
+    return;
+
+#if !defined(EMSCRIPTEN)
+  if (workers.empty() && batch_count > 1)
+    start();
+#endif
+
+  if (workers.empty() || batch_count == 1)
+  {
+    for (size_t i = 0; i < batch_count; i++)
+      batch_job(batch_context, i);
+    return;
+  }
+
+  {
+    std::unique_lock lock(mutex);
+
+    // A worker that woke up late for the previous batch could still take an index of this one
+    finished.wait(lock, [&] { return busy == 0; });
+
+    job     = batch_job;
+    context = batch_context;
+    count   = batch_count;
+    next_index.store(0);
+    remaining.store(batch_count);
+    batch += 1;
+  }
+  requested.notify_all();
+
+  take_jobs(batch_job, batch_context, batch_count);
+
+  std::unique_lock lock(mutex);
+  finished.wait(lock, [&] { return remaining.load() == 0; });
+}
+
+void WorkerPool::stop()
+{
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+
+  requested.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+  workers.clear();
+
+  std::lock_guard lock(mutex);
+  stopping = false;
+}
+
+void WorkerPool::start()
+{
+  const size_t hardware_threads = std::thread::hardware_concurrency();
+  const size_t worker_count     = std::min(hardware_threads > 1 ? hardware_threads - 1 : 0, MAX_WORKERS);
+
+  for (size_t i = 0; i < worker_count; i++)
+    workers.emplace_back(&WorkerPool::work, this);
+}
+
+void WorkerPool::work()
+{
+  std::unique_lock lock(mutex);
+  size_t seen_batch = batch;
+
+  while (true)
+  {
+    requested.wait(lock, [&] { return stopping || batch != seen_batch; });
+    if (stopping)
+      break;
+
+    seen_batch                = batch;
+    const Job batch_job       = job;
+    void *const batch_context = context;
+    const size_t batch_count  = count;
+    busy += 1;
+
+    lock.unlock();
+    take_jobs(batch_job, batch_context, batch_count);
+    lock.lock();
+
+    busy -= 1;
+    if (busy == 0)
+      finished.notify_all();
+  }
+}
+
+void WorkerPool::take_jobs(Job batch_job, void *batch_context, size_t batch_count)
+{
+  for (size_t i = next_index.fetch_add(1); i < batch_count; i = next_index.fetch_add(1))
+  {
+    batch_job(batch_context, i);
+
+    if (remaining.fetch_sub(1) == 1)
+    {
+      std::lock_guard lock(mutex);
+      finished.notify_all();
+    }
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs batches of jobs on worker threads. The calling thread takes jobs too and returns when the whole batch is done.
+// Web builds run without threads, so every job runs on the calling thread.
+struct WorkerPool
+{
+  using Job = void (*)(void *context, size_t index);
+
+  [[nodiscard]] static WorkerPool &get();
+  ~WorkerPool();
+
+  // Calls job with every index below count, in no particular order and possibly concurrently
+  void run(Job job, void *context, size_t count);
+
+  // Joins the workers, they are started again by the next run
+  void stop();
+
+  [[nodiscard]] inline size_t worker_count() const
+  {
+    return workers.size();
+  }
+
+private:
+  void start();
+  void work();
+  void take_jobs(Job batch_job, void *batch_context, size_t batch_count);
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable requested;
+  std::condition_variable finished;
+
+  // Current batch, written under the mutex before batch is incremented
+  Job job{ nullptr };
+  void *context{ nullptr };
+  size_t count{ 0 };
+  size_t batch{ 0 };
+  // Workers that hold a copy of a batch
+  size_t busy{ 0 };
+  bool stopping{ false };
+
+  std::atomic<size_t> next_index{ 0 };
+  std::atomic<size_t> remaining{ 0 };
+};
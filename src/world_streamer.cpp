@@ -0,0 +1,352 @@
+#include "world_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+#include "level_streamer.hpp"
+#include "renderers.hpp"
+
+namespace Level
+{
+[[nodiscard]] static size_t image_memory(const Image &image)
+{
+  return static_cast<size_t>(GetPixelDataSize(image.width, image.height, image.format));
+}
+
+// Gap between two rectangles, zero when they touch or overlap
+[[nodiscard]] static float distance(const Rectangle &a, const Rectangle &b)
+{
+  const float dx = std::max({ a.x - (b.x + b.width), b.x - (a.x + a.width), 0.0f });
+  const float dy = std::max({ a.y - (b.y + b.height), b.y - (a.y + a.height), 0.0f });
+  return std::hypot(dx, dy);
+}
+
+bool WorldStreamer::Room::is_uploaded() const
+{
+  return !prepared || uploaded_chunks == prepared->tile_chunks.size();
+}
+
+Rectangle WorldStreamer::Room::bounds() const
+{
+  return { static_cast<float>(offset.x),
+           static_cast<float>(offset.y),
+           static_cast<float>(width),
+           static_cast<float>(height) };
+}
+
+WorldStreamer &WorldStreamer::get()
+{
+  static WorldStreamer instance;
+  return instance;
+}
+
+WorldStreamer::Room *WorldStreamer::find(const LevelName &name)
+{
+  const auto room_it = std::find_if(rooms.begin(), rooms.end(), [&](const Room &room) { return room.name == name; });
+  return room_it != rooms.end() ? &*room_it : nullptr;
+}
+
+WorldStreamer::Room &WorldStreamer::add_room(const LevelLoader &level_loader, PreparedLevel &prepared)
+{
+  Room &room    = rooms.emplace_back();
+  room.name     = level_loader.name;
+  room.world_x  = level_loader.world_x;
+  room.world_y  = level_loader.world_y;
+  room.width    = level_loader.width;
+  room.height   = level_loader.height;
+  room.offset   = TilePosition{ static_cast<int32_t>(room.world_x - origin_x), static_cast<int32_t>(room.world_y - origin_y) };
+  room.entity   = create_entity();
+  set_persistent(room.entity);
+
+  for (const auto &chunk : prepared.tile_chunks)
+    room.memory += image_memory(chunk.base) + image_memory(chunk.normal);
+
+  for (const auto tile_index : prepared.unbaked_tiles)
+    Level::add_tile_renderer(level_loader, room.entity, level_loader.tiles[tile_index], room.offset);
+
+  return room;
+}
+
+void WorldStreamer::upload(Room &room, size_t count)
+{
+  if (!room.prepared)
+    return;
+
+  auto &chunks = room.prepared->tile_chunks;
+  for (; count > 0 && room.uploaded_chunks < chunks.size(); count--)
+  {
+    Level::upload_tile_chunk(chunks[room.uploaded_chunks], room.entity, room.offset);
+    room.uploaded_chunks += 1;
+  }
+}
+
+void WorldStreamer::place_rooms()
+{
+  for (auto &room : rooms)
+  {
+    const TilePosition offset{ static_cast<int32_t>(room.world_x - origin_x),
+                               static_cast<int32_t>(room.world_y - origin_y) };
+    const int32_t dx = offset.x - room.offset.x;
+    const int32_t dy = offset.y - room.offset.y;
+    if (dx == 0 && dy == 0)
+      continue;
+
+    for (auto *chunk_renderer : get_components<TileChunkRenderer>(room.entity))
+    {
+      chunk_renderer->x += dx;
+      chunk_renderer->y += dy;
+    }
+
+    for (auto *tile_renderer : get_components<TileRenderer>(room.entity))
+      tile_renderer->set_position(tile_renderer->x + dx, tile_renderer->y + dy);
+
+    room.offset = offset;
+  }
+}
+
+void WorldStreamer::evict(size_t index)
+{
+  auto &room = rooms[index];
+  printf("Evicting room %s (%.2f MB)\n", room.name.c_str(), room.memory / (1024.0 * 1024.0));
+
+  if (std::find(neighbours.begin(), neighbours.end(), room.name) != neighbours.end())
+    evicted_neighbours.push_back({ room.name, room.world_x, room.world_y, room.width, room.height, room.memory });
+
+  unset_persistent(room.entity);
+  destroy_entity(room.entity);
+  rooms.erase(rooms.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+std::unique_ptr<PreparedLevel> WorldStreamer::take(const LevelName &name, const LoadSettings &load_settings)
+{
+  Room *room = find(name);
+  if (!room)
+    return LevelStreamer::get().take(name, load_settings);
+
+  if (room->prepared && room->prepared->settings == load_settings)
+  {
+    upload(*room, room->prepared->tile_chunks.size());
+    return std::move(room->prepared);
+  }
+
+  // The tiles of the room are resident, only the level data is loaded again
+  LoadSettings data_settings     = load_settings;
+  data_settings.bake_tile_chunks = false;
+  auto prepared                  = Level::prepare(name, data_settings);
+  prepared->settings             = load_settings;
+  prepared->unbaked_tiles.clear();
+  return prepared;
+}
+
+void WorldStreamer::enter(const LevelLoader &level_loader, PreparedLevel &prepared)
+{
+  settings = prepared.settings;
+  current  = level_loader.name;
+  origin_x = level_loader.world_x;
+  origin_y = level_loader.world_y;
+
+  place_rooms();
+
+  if (Room *room = find(current); room)
+  {
+    room->prepared.reset();
+    room->uploaded_chunks = 0;
+  }
+  else
+  {
+    Room &new_room = add_room(level_loader, prepared);
+    for (auto &chunk : prepared.tile_chunks)
+      Level::upload_tile_chunk(chunk, new_room.entity, new_room.offset);
+  }
+
+  neighbours.clear();
+  requested.clear();
+  evicted_neighbours.clear();
+  for (const auto &[_, neighbour] : level_loader.neighbours)
+  {
+    if (std::find(neighbours.begin(), neighbours.end(), neighbour) != neighbours.end())
+      continue;
+
+    neighbours.push_back(neighbour);
+    if (!find(neighbour))
+      requested.push_back(neighbour);
+  }
+
+  LevelStreamer::get().prefetch(requested, settings);
+
+  printf("World: %zu rooms resident (%.2f MB), %zu requested\n",
+         rooms.size(),
+         memory_usage() / (1024.0 * 1024.0),
+         requested.size());
+}
+
+void WorldStreamer::update(Rectangle view)
+{
+  // Neighbours evicted for the budget are requested again when the camera comes close and they fit again
+  bool requests_changed = false;
+  for (auto evicted_it = evicted_neighbours.begin(); evicted_it != evicted_neighbours.end();)
+  {
+    const Rectangle bounds{ static_cast<float>(evicted_it->world_x - origin_x),
+                            static_cast<float>(evicted_it->world_y - origin_y),
+                            static_cast<float>(evicted_it->width),
+                            static_cast<float>(evicted_it->height) };
+    if (distance(view, bounds) > activation_distance || memory_usage() + evicted_it->memory > memory_budget)
+    {
+      ++evicted_it;
+      continue;
+    }
+
+    requested.push_back(evicted_it->name);
+    evicted_it       = evicted_neighbours.erase(evicted_it);
+    requests_changed = true;
+  }
+
+  if (requests_changed)
+    LevelStreamer::get().prefetch(requested, settings);
+
+  // Neighbours prepared by the streaming thread become resident, their chunks are uploaded over the next frames
+  for (auto name_it = requested.begin(); name_it != requested.end();)
+  {
+    auto prepared = LevelStreamer::get().try_take(*name_it, settings);
+    if (!prepared)
+    {
+      ++name_it;
+      continue;
+    }
+
+    Room &room    = add_room(prepared->level_loader, *prepared);
+    room.prepared = std::move(prepared);
+    name_it       = requested.erase(name_it);
+  }
+
+  std::vector<float> distances(rooms.size());
+  for (size_t i = 0; i < rooms.size(); i++)
+  {
+    distances[i]    = rooms[i].name == current ? 0.0f : distance(view, rooms[i].bounds());
+    rooms[i].active = distances[i] <= activation_distance;
+  }
+
+  std::vector<size_t> order(rooms.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+
+  // Rooms closest to the camera are uploaded first, a few chunks per frame
+  size_t uploads = uploads_per_frame;
+  for (const auto index : order)
+  {
+    auto &room = rooms[index];
+    if (!room.active || room.is_uploaded())
+      continue;
+
+    const size_t pending = room.prepared->tile_chunks.size() - room.uploaded_chunks;
+    const size_t count   = std::min(uploads, pending);
+    upload(room, count);
+    uploads -= count;
+    if (uploads == 0)
+      break;
+  }
+
+  // Farthest rooms are evicted first when they are out of range or the memory budget is exceeded.
+  // Neighbours of the current room are only evicted to stay within the budget, and requested again later.
+  size_t memory = memory_usage();
+  std::vector<size_t> evicted;
+  for (auto order_it = order.rbegin(); order_it != order.rend(); ++order_it)
+  {
+    const auto &room = rooms[*order_it];
+    if (room.name == current)
+      continue;
+
+    const bool is_neighbour = std::find(neighbours.begin(), neighbours.end(), room.name) != neighbours.end();
+    if ((!is_neighbour && distances[*order_it] > eviction_distance) || memory > memory_budget)
+    {
+      memory -= room.memory;
+      evicted.push_back(*order_it);
+    }
+  }
+
+  std::sort(evicted.begin(), evicted.end(), std::greater<>());
+  for (const auto index : evicted)
+    evict(index);
+}
+
+Rectangle WorldStreamer::get_bounds(Vector2 target, Vector2 view_size) const
+{
+  const auto is_visible = [&](const Room &room) { return room.name == current || (room.active && room.is_uploaded()); };
+  const auto contains   = [](const Rectangle &bounds, Vector2 point)
+  {
+    return point.x >= bounds.x && point.x < bounds.x + bounds.width && point.y >= bounds.y &&
+           point.y < bounds.y + bounds.height;
+  };
+
+  // The room under the target, the current room while the target is outside of every visible room
+  const Room *base_room = nullptr;
+  for (const auto &room : rooms)
+  {
+    if (room.name == current && (!base_room || !contains(base_room->bounds(), target)))
+      base_room = &room;
+    else if (room.name != current && is_visible(room) && contains(room.bounds(), target))
+      base_room = &room;
+  }
+
+  if (!base_room)
+    return Rectangle{};
+
+  const Rectangle base = base_room->bounds();
+
+  // View clamped to the base room the way the camera is clamped, neighbours have to cover it on the other axis
+  const float view_left =
+    std::min(std::max(target.x - view_size.x / 2.0f, base.x), base.x + base.width - view_size.x);
+  const float view_top =
+    std::min(std::max(target.y - view_size.y / 2.0f, base.y), base.y + base.height - view_size.y);
+
+  Rectangle horizontal      = base;
+  Rectangle vertical        = base;
+  float horizontal_distance = std::numeric_limits<float>::max();
+  float vertical_distance   = std::numeric_limits<float>::max();
+
+  for (const auto &room : rooms)
+  {
+    if (&room == base_room || !is_visible(room))
+      continue;
+
+    const Rectangle bounds    = room.bounds();
+    const float room_distance = distance(Rectangle{ target.x, target.y, 0.0f, 0.0f }, bounds);
+
+    const bool touches_x = bounds.x + bounds.width == base.x || bounds.x == base.x + base.width;
+    if (touches_x && bounds.y <= view_top && bounds.y + bounds.height >= view_top + view_size.y)
+    {
+      const float left    = std::min(horizontal.x, bounds.x);
+      const float right   = std::max(horizontal.x + horizontal.width, bounds.x + bounds.width);
+      horizontal          = Rectangle{ left, base.y, right - left, base.height };
+      horizontal_distance = std::min(horizontal_distance, room_distance);
+    }
+
+    const bool touches_y = bounds.y + bounds.height == base.y || bounds.y == base.y + base.height;
+    if (touches_y && bounds.x <= view_left && bounds.x + bounds.width >= view_left + view_size.x)
+    {
+      const float top    = std::min(vertical.y, bounds.y);
+      const float bottom = std::max(vertical.y + vertical.height, bounds.y + bounds.height);
+      vertical           = Rectangle{ base.x, top, base.width, bottom - top };
+      vertical_distance  = std::min(vertical_distance, room_distance);
+    }
+  }
+
+  // Extending both axes would open the corner between the neighbours, so only the closer neighbour counts
+  return horizontal_distance <= vertical_distance ? horizontal : vertical;
+}
+
+void WorldStreamer::clear()
+{
+  while (!rooms.empty())
+    evict(rooms.size() - 1);
+
+  neighbours.clear();
+  requested.clear();
+  current.clear();
+}
+
+} // namespace Level
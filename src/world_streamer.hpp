@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <raylib.h>
+
+#include "level.hpp"
+
+namespace Level
+{
+// Keeps the tiles of the current room and the rooms around it resident, placed by their LDtk world coordinates
+// relative to the current room. Gameplay entities only exist for the room the player is in, because their
+// logic works in room coordinates.
+struct WorldStreamer
+{
+  struct Room
+  {
+    LevelName name;
+    int64_t world_x{ 0 };
+    int64_t world_y{ 0 };
+    int64_t width{ 0 };
+    int64_t height{ 0 };
+
+    // Persistent entity that owns the tile renderers of the room
+    ::Entity entity{ INVALID_ENTITY };
+    TilePosition offset{};
+
+    // Level data kept for entering the room, its chunk images are uploaded a few per frame
+    std::unique_ptr<PreparedLevel> prepared;
+    size_t uploaded_chunks{ 0 };
+    size_t memory{ 0 };
+    bool active{ false };
+
+    [[nodiscard]] bool is_uploaded() const;
+    [[nodiscard]] Rectangle bounds() const;
+  };
+
+  [[nodiscard]] static WorldStreamer &get();
+
+  // Makes the entered room resident, places all rooms relative to it and requests its neighbours
+  void enter(const LevelLoader &level_loader, PreparedLevel &prepared);
+
+  // Hands over the level data of a room, the tiles of resident rooms are not prepared again
+  [[nodiscard]] std::unique_ptr<PreparedLevel> take(const LevelName &name, const LoadSettings &settings);
+
+  // Collects prepared neighbours, uploads pending chunks and evicts rooms far from the camera.
+  // The view is the camera rectangle in the coordinates of the current room.
+  void update(Rectangle view);
+
+  // Area the camera can show around its target, in the coordinates of the current room. It is the room under the
+  // target, extended along one axis into uploaded neighbours that cover the whole view on the other axis, so the
+  // camera never shows space that no room covers.
+  [[nodiscard]] Rectangle get_bounds(Vector2 target, Vector2 view_size) const;
+
+  void clear();
+
+  [[nodiscard]] inline size_t memory_usage() const
+  {
+    size_t memory = 0;
+    for (const auto &room : rooms)
+      memory += room.memory;
+    return memory;
+  }
+
+  [[nodiscard]] inline size_t room_count() const
+  {
+    return rooms.size();
+  }
+
+  // Rooms closer to the camera than this are uploaded and can be scrolled into
+  float activation_distance{ 160.0f };
+  // Rooms that are not neighbours of the current room are evicted farther away than this
+  float eviction_distance{ 640.0f };
+  size_t memory_budget{ 64 * 1024 * 1024 };
+  size_t uploads_per_frame{ 2 };
+
+private:
+  // Neighbour that was evicted to stay within the memory budget
+  struct EvictedRoom
+  {
+    LevelName name;
+    int64_t world_x{ 0 };
+    int64_t world_y{ 0 };
+    int64_t width{ 0 };
+    int64_t height{ 0 };
+    size_t memory{ 0 };
+  };
+
+  [[nodiscard]] Room *find(const LevelName &name);
+  Room &add_room(const LevelLoader &level_loader, PreparedLevel &prepared);
+  void upload(Room &room, size_t count);
+  void place_rooms();
+  void evict(size_t index);
+
+  std::vector<Room> rooms;
+  std::vector<LevelName> neighbours;
+  std::vector<LevelName> requested;
+  std::vector<EvictedRoom> evicted_neighbours;
+  LevelName current;
+  LoadSettings settings;
+  int64_t origin_x{ 0 };
+  int64_t origin_y{ 0 };
+};
+
+} // namespace Level